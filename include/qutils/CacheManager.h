@@ -4,6 +4,7 @@
 // qutils
 #include "qutils/Macros.h"
 #include "qutils/SqliteManager.h"
+#include "qutils/SqliteMaintenanceScheduler.h"
 
 #ifdef QUTILS_APP_NAME
 #define CACHE_DB_FILE_NAME STRINGIFY(QUTILS_APP_NAME) "_cache.sqlite"
@@ -76,12 +77,18 @@ private:
     QString m_DatabaseName, m_CacheTableName;
     zmc::SqliteManager m_SqlManager;
     QSqlDatabase m_Database;
+    SqliteMaintenanceScheduler *m_MaintenanceScheduler;
 
     static QList<CacheManager *> m_Instances;
     static int m_InstanceLastIndex;
 
 private:
-    void createTable();
+    /**
+     * @brief Creates the table and the unique index on the name column If they do not exist. If the index cannot be created, the
+     * database is not used.
+     * @return bool
+     */
+    bool createTable();
 
     /**
      * @brief Opens the database at m_DatabasePath If it is not open. If it is open, does nothing.
@@ -93,6 +100,17 @@ private:
      */
     void restartDatabase();
 
+    /**
+     * @brief Switches the database to incremental auto vacuum and starts reclaiming the pages freed by the removed entries when the
+     * database is idle.
+     */
+    void startMaintenance();
+
+    /**
+     * @brief Returns true If any of the instances has a connection to cacheChanged().
+     * @return bool
+     */
+    bool hasCacheChangedListeners() const;
     void emitCacheChangedInAllInstances(const QString &cacheName, const QVariant &oldCachedValue, const QVariant &newCachedValue);
     void emitCacheChanged(const QString &cacheName, const QVariant &oldCachedValue, const QVariant &newCachedValue);
 
@@ -0,0 +1,72 @@
+#pragma once
+// Qt
+#include <QIODevice>
+
+// Forward declarations
+struct z_stream_s;
+
+namespace zmc
+{
+
+/**
+ * @brief The GzipDevice class is a write-only device that compresses everything written to it in gzip format and writes the result to
+ * the target device. The data is compressed as it is written, so the uncompressed data is never held in memory. The target device must
+ * be open for writing and must outlive this device. Call close() to write the end of the gzip stream.
+ * **Example Usage:**
+ * @code
+ *    QFile file("export.ndjson.gz");
+ *    file.open(QIODevice::WriteOnly);
+ *    GzipDevice gzip(&file);
+ *    gzip.open(QIODevice::WriteOnly);
+ *    gzip.write(data);
+ *    gzip.close();
+ * @endcode
+ */
+class GzipDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param target
+     * @param compressionLevel Between 0 and 9, -1 uses the zlib default.
+     * @param parent
+     */
+    explicit GzipDevice(QIODevice *target, int compressionLevel = -1, QObject *parent = nullptr);
+    ~GzipDevice();
+
+    /**
+     * @brief Only QIODevice::WriteOnly is supported.
+     * @param mode
+     * @return bool
+     */
+    bool open(OpenMode mode) override;
+
+    /**
+     * @brief Flushes the remaining compressed data and writes the gzip trailer. Does not close the target device.
+     */
+    void close() override;
+
+    bool isSequential() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    QIODevice *m_Target;
+    const int m_CompressionLevel;
+    z_stream_s *m_Stream;
+
+private:
+    /**
+     * @brief Compresses the given data and writes the output to the target device.
+     * @param data
+     * @param size
+     * @param flush Z_NO_FLUSH or Z_FINISH
+     * @return bool Returns false If compression or writing to the target fails.
+     */
+    bool deflateData(const char *data, qint64 size, int flush);
+};
+
+}
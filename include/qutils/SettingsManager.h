@@ -85,7 +85,12 @@ private:
     static int m_InstanceLastIndex;
 
 private:
-    void createTable();
+    /**
+     * @brief Creates the table and the unique index on the name column If they do not exist. If the index cannot be created, the
+     * database is not used.
+     * @return bool
+     */
+    bool createTable();
 
     /**
      * @brief Opens the database at m_DatabasePath If it is not open. If it is open, does nothing.
@@ -97,6 +102,11 @@ private:
      */
     void restartDatabase();
 
+    /**
+     * @brief Returns true If any of the instances has a connection to settingChanged().
+     * @return bool
+     */
+    bool hasSettingChangedListeners() const;
     void emitSettingChangedInAllInstances(const QString &settingName, const QVariant &oldSettingValue, const QVariant &newSettingValue);
     void emitSettingChanged(const QString &settingName, const QVariant &oldSettingValue, const QVariant &newSettingValue);
 
@@ -0,0 +1,127 @@
+#pragma once
+// Qt
+#include <QThreadPool>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+// qutils
+#include "qutils/SqliteManager.h"
+// std
+#include <utility>
+
+namespace zmc
+{
+
+/**
+ * @brief The SqliteAsyncExecutor class runs database operations on a dedicated worker thread, so a slow query does not block the
+ * caller's thread (e.g the GUI thread). The executor owns its own connection to the database which is opened on the worker thread
+ * with the first operation and is only ever used from that thread.
+ *
+ * Operations are executed one at a time in the order they are submitted. The results are delivered either with a QFuture, or with a
+ * callback that is called on the thread of the given context object.
+ * **Example Usage:**
+ * @code
+ *    SqliteAsyncExecutor executor(databasePath);
+ *    executor.run([](SqliteManager &manager, QSqlDatabase &db) {
+ *        return manager.executeSelectQuery(db, "SELECT * FROM my_table");
+ *    }, this, [this](const QList<QMap<QString, QVariant>> &rows) {
+ *        // Called on the thread of this.
+ *        m_Model->setRows(rows);
+ *    });
+ *
+ *    QFuture<bool> future = executor.insertIntoTable("my_table", row);
+ * @endcode
+ */
+class SqliteAsyncExecutor
+{
+public:
+    explicit SqliteAsyncExecutor(const QString &databasePath);
+
+    /**
+     * @brief Waits for the submitted operations to finish and closes the connection.
+     */
+    ~SqliteAsyncExecutor();
+
+    SqliteAsyncExecutor(const SqliteAsyncExecutor &other) = delete;
+    SqliteAsyncExecutor &operator=(const SqliteAsyncExecutor &other) = delete;
+
+    QString getDatabasePath() const;
+
+    /**
+     * @brief Runs `task` on the worker thread. The task is called with the executor's SqliteManager and connection, and its return
+     * value is the result of the future. Do not keep the manager or the connection beyond the task, they belong to the worker thread.
+     * @param task
+     * @return QFuture<T> Where T is the return type of the task.
+     */
+    template<typename Function>
+    auto run(Function task) -> QFuture<decltype(task(std::declval<SqliteManager &>(), std::declval<QSqlDatabase &>()))>
+    {
+        return QtConcurrent::run(&m_ThreadPool, [this, task]() {
+            return task(m_SqlManager, getDatabase());
+        });
+    }
+
+    /**
+     * @brief Runs `task` on the worker thread and calls `callback` with the result on the thread of `context`. `context` must live in
+     * the calling thread. If `context` is destroyed before the task finishes, `callback` is not called. The task must return a value.
+     * @param task
+     * @param context
+     * @param callback
+     */
+    template<typename Function, typename Callback>
+    void run(Function task, QObject *context, Callback callback)
+    {
+        using ResultType = decltype(task(std::declval<SqliteManager &>(), std::declval<QSqlDatabase &>()));
+        QFutureWatcher<ResultType> *watcher = new QFutureWatcher<ResultType>(context);
+        QObject::connect(watcher, &QFutureWatcherBase::finished, watcher, [watcher, callback]() {
+            callback(watcher->result());
+            watcher->deleteLater();
+        });
+
+        watcher->setFuture(run(task));
+    }
+
+    QFuture<QList<QMap<QString, QVariant>>> executeSelectQuery(const QString &sqlQueryStr, const QVariantList &bindValues = QVariantList());
+    QFuture<QList<QMap<QString, QVariant>>> getFromTable(const QString &tableName, const SqliteWhere &where = SqliteWhere(),
+                                                         const unsigned int &limit = -1);
+    QFuture<bool> insertIntoTable(const QString &tableName, const QMap<QString, QVariant> &row);
+    QFuture<SqliteManager::BatchResult> insertManyIntoTable(const QString &tableName, const QList<QMap<QString, QVariant>> &rows);
+    QFuture<bool> updateInTable(const QString &tableName, const QMap<QString, QVariant> &row, const SqliteWhere &where);
+    QFuture<bool> deleteInTable(const QString &tableName, const SqliteWhere &where);
+    QFuture<bool> exists(const QString &tableName, const SqliteWhere &where);
+
+    /**
+     * @brief Runs SqliteManager::backup() on the worker thread with the executor's connection. The callback is called on the worker
+     * thread. The other operations of the executor wait until the backup is finished, but the other connections can still use the
+     * database.
+     * @param destinationPath
+     * @param pagesPerStep
+     * @param callback
+     * @return QFuture<bool>
+     */
+    QFuture<bool> backup(const QString &destinationPath, int pagesPerStep = 100,
+                         const SqliteManager::BackupProgressCallback &callback = SqliteManager::BackupProgressCallback());
+    QFuture<bool> vacuumInto(const QString &destinationPath);
+
+    /**
+     * @brief Blocks until all of the submitted operations are finished.
+     */
+    void waitForDone();
+
+private:
+    const QString m_DatabasePath;
+    const QString m_ConnectionName;
+    // Only accessed from the worker thread.
+    SqliteManager m_SqlManager;
+    QSqlDatabase m_Database;
+    QThreadPool m_ThreadPool;
+
+private:
+    /**
+     * @brief Opens the connection If it is not open yet. Must be called from the worker thread.
+     * @return QSqlDatabase &
+     */
+    QSqlDatabase &getDatabase();
+};
+
+}
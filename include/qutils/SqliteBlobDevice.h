@@ -0,0 +1,94 @@
+#pragma once
+// Qt
+#include <QIODevice>
+#include <QSqlDatabase>
+
+// Forward declarations
+struct sqlite3_blob;
+
+namespace zmc
+{
+
+class SqliteManager;
+
+/**
+ * @brief The SqliteBlobDevice class reads and writes a single BLOB cell incrementally with the sqlite3_blob API, so a large BLOB can be
+ * streamed in fixed-size chunks instead of being loaded into memory as a whole. The size of a BLOB cannot be changed through the device.
+ * To write a new BLOB, first allocate it with preallocate() which fills the cell with zeros of the given size, then open the device and
+ * write the data.
+ *
+ * The device is bound to the row with the given rowid. If the row is changed or deleted by another statement while the device is open,
+ * the device expires and the following reads and writes fail. Writes are part of the active transaction, If there's no transaction every
+ * write is committed on its own, so wrap a series of writes in SqliteManager::Transaction.
+ *
+ * Only available when qutils is built with `CONFIG += QUTILS_SQLITE_NATIVE`, which links against the system SQLite. Qt must also use
+ * the system SQLite (`-system-sqlite`), because the handle of the connection comes from Qt's SQLite driver.
+ * **Example Usage:**
+ * @code
+ *    QFile file("attachment.pdf");
+ *    file.open(QIODevice::ReadOnly);
+ *    man.executeQuery(db, "INSERT INTO attachments (name) VALUES(?)", {"attachment.pdf"});
+ *    const qint64 rowID = man.executeSelectQuery(db, "SELECT last_insert_rowid() AS id").first().value("id").toLongLong();
+ *    SqliteBlobDevice::preallocate(man, db, "attachments", "data", rowID, file.size());
+ *
+ *    SqliteBlobDevice blob(db, "attachments", "data", rowID);
+ *    blob.open(QIODevice::WriteOnly);
+ *    while (file.atEnd() == false) {
+ *        blob.write(file.read(64 * 1024));
+ *    }
+ * @endcode
+ */
+class SqliteBlobDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    SqliteBlobDevice(const QSqlDatabase &database, const QString &tableName, const QString &columnName, qint64 rowID,
+                     QObject *parent = nullptr);
+    ~SqliteBlobDevice();
+
+    /**
+     * @brief Opens the BLOB for reading or for reading and writing. QIODevice::Append and QIODevice::Truncate are not supported since
+     * the size of the BLOB is fixed.
+     * @param mode
+     * @return bool
+     */
+    bool open(OpenMode mode) override;
+    void close() override;
+
+    /**
+     * @brief Moves the open device to another row of the same table and column, this is faster than opening a new device.
+     * @param rowID
+     * @return bool
+     */
+    bool reopen(qint64 rowID);
+
+    qint64 size() const override;
+    qint64 getRowID() const;
+
+    /**
+     * @brief Sets the cell to a BLOB of `size` zeros so that it can be written with a SqliteBlobDevice.
+     * @param manager
+     * @param database
+     * @param tableName
+     * @param columnName
+     * @param rowID
+     * @param size
+     * @return bool Returns false If the row does not exist.
+     */
+    static bool preallocate(SqliteManager &manager, QSqlDatabase &database, const QString &tableName, const QString &columnName,
+                            qint64 rowID, qint64 size);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    QSqlDatabase m_Database;
+    const QString m_TableName, m_ColumnName;
+    qint64 m_RowID;
+    sqlite3_blob *m_Blob;
+    qint64 m_Size;
+};
+
+}
@@ -0,0 +1,157 @@
+#pragma once
+// Qt
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QMetaObject>
+#include <QThread>
+// qutils
+#include "qutils/SqliteManager.h"
+
+namespace zmc
+{
+
+/**
+ * @brief The SqliteConnectionPool class hands out one connection per thread to the same database, so read queries can run in parallel
+ * on different threads. The database is switched to WAL mode, which lets the readers run while a writer is active.
+ *
+ * A connection belongs to the thread that acquired it. It stays open after the last Connection of that thread goes out of scope, so
+ * the next lease of the thread reuses it with its prepared statements and schema cache. It is closed when the thread finishes or the
+ * pool is destroyed. A connection is only ever closed on the thread that owns it. The number of open connections is capped. When the cap
+ * is reached, the connections that are not leased are marked for eviction and the new thread waits. A marked connection is closed by
+ * its own thread when that thread releases it again or finishes, so a thread that keeps an idle connection without using the pool
+ * again holds its slot until it finishes.
+ * **Example Usage:**
+ * @code
+ *    SqliteConnectionPool pool(databasePath, 4);
+ *    // In any thread
+ *    SqliteConnectionPool::Connection connection(pool);
+ *    if (connection.isValid()) {
+ *        const QList<QMap<QString, QVariant>> rows = connection.getManager().getFromTable(connection.getDatabase(), "my_table", where);
+ *    }
+ * @endcode
+ */
+class SqliteConnectionPool
+{
+private:
+    struct ThreadConnection {
+        QString connectionName;
+        QThread *thread = nullptr;
+        // The QThread of a finished adopted thread can be destroyed and its address reused, the id tells the threads apart.
+        Qt::HANDLE threadID = nullptr;
+        SqliteManager manager;
+        QSqlDatabase database;
+        int referenceCount = 0;
+        // Set when a waiting thread needs the slot, the owning thread closes the connection on its next release.
+        bool isEvictionRequested = false;
+        // Lives in the owning thread and is the context of threadFinishedConnection.
+        QObject *context = nullptr;
+        // Closes the connection when its thread finishes.
+        QMetaObject::Connection threadFinishedConnection;
+    };
+
+public:
+    /**
+     * @brief Leases the connection of the current thread from the pool. Connections of the same thread can be nested, they all refer
+     * to the same connection.
+     */
+    class Connection
+    {
+    public:
+        /**
+         * @brief Acquires the connection for the current thread. If the pool is full, waits at most `timeout` milliseconds for a
+         * connection to be released. A negative timeout waits forever.
+         * @param pool
+         * @param timeout
+         */
+        explicit Connection(SqliteConnectionPool &pool, int timeout = -1);
+        ~Connection();
+
+        Connection(const Connection &other) = delete;
+        Connection &operator=(const Connection &other) = delete;
+
+        /**
+         * @brief Returns false If the connection could not be acquired in time or the database could not be opened.
+         * @return bool
+         */
+        bool isValid() const;
+
+        QSqlDatabase &getDatabase();
+
+        /**
+         * @brief Returns the SqliteManager that belongs to this thread's connection. Use this manager with the connection so that the
+         * cached statements are released when the connection is closed.
+         * @return SqliteManager &
+         */
+        SqliteManager &getManager();
+
+    private:
+        SqliteConnectionPool &m_Pool;
+        ThreadConnection *m_ThreadConnection;
+    };
+
+public:
+    /**
+     * @brief Creates a pool for the database at `databasePath`. The connections are opened on demand.
+     * @param databasePath
+     * @param maxConnectionCount If it is less than 1, QThread::idealThreadCount() is used.
+     * @param options Applied to every connection. The journal mode is always WAL, and If the busy timeout is not set 5 seconds is used.
+     */
+    explicit SqliteConnectionPool(const QString &databasePath, int maxConnectionCount = 0,
+                                  const SqliteManager::OpenOptions &options = SqliteManager::OpenOptions());
+    /**
+     * @brief Closes the connections of the current thread. The connections of the threads that are still running are not closed from
+     * here, they are logged and closed by their threads when they finish. None of them can be leased at this point.
+     */
+    ~SqliteConnectionPool();
+
+    SqliteConnectionPool(const SqliteConnectionPool &other) = delete;
+    SqliteConnectionPool &operator=(const SqliteConnectionPool &other) = delete;
+
+    QString getDatabasePath() const;
+    int getMaxConnectionCount() const;
+    int getOpenConnectionCount() const;
+
+private:
+    const QString m_DatabasePath;
+    const int m_MaxConnectionCount;
+    SqliteManager::OpenOptions m_Options;
+    // Thread -> Connection of that thread
+    QHash<QThread *, ThreadConnection *> m_Connections;
+    mutable QMutex m_Mutex;
+    QWaitCondition m_ConnectionReleased;
+    // Number of threads waiting in acquire() for a slot.
+    int m_WaitingCount;
+
+private:
+    ThreadConnection *acquire(int timeout);
+    void release(ThreadConnection *threadConnection);
+
+    /**
+     * @brief Marks the connections that are not leased for eviction. Must be called with the mutex locked.
+     */
+    void requestEviction();
+
+    /**
+     * @brief Called when a thread that has a connection finishes. finished is emitted from the thread itself, except for adopted
+     * threads on some platforms where the thread is already gone at this point.
+     * @param thread
+     */
+    void onThreadFinished(QThread *thread);
+
+    /**
+     * @brief Closes and deletes a connection that is already removed from the pool. Must be called with the mutex unlocked, from the
+     * owning thread or after the owning thread is gone.
+     * @param threadConnection
+     */
+    static void close(ThreadConnection *threadConnection);
+
+    /**
+     * @brief Opens the connection and applies the options. Called from the thread that will use the connection.
+     * @param threadConnection
+     * @return bool
+     */
+    bool open(ThreadConnection *threadConnection) const;
+};
+
+}
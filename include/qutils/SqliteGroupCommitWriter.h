@@ -0,0 +1,95 @@
+#pragma once
+// Qt
+#include <QObject>
+#include <QTimer>
+#include <QFuture>
+#include <QFutureInterface>
+// qutils
+#include "qutils/SqliteManager.h"
+
+namespace zmc
+{
+
+/**
+ * @brief The SqliteGroupCommitWriter class collects small independent writes and commits them together in a single transaction, so they
+ * share one commit and one sync instead of paying for their own. The queued writes are flushed `flushInterval` milliseconds after the
+ * first write of the group is queued, or as soon as `maxOperationCount` writes are waiting, whichever comes first.
+ *
+ * Every write runs in its own savepoint, so a failing write is rolled back on its own and does not affect the others in the group. Every
+ * write gets a future that finishes when its group is committed, its result is true If the write succeeded and the group was committed.
+ * How durable a committed write is depends on `PRAGMA synchronous` of the connection.
+ *
+ * The writes are run on the thread the writer lives in, with the given manager and connection. Queued writes are flushed when the
+ * writer is destroyed, the writes that cannot be flushed then finish with false.
+ * **Example Usage:**
+ * @code
+ *    SqliteGroupCommitWriter *writer = new SqliteGroupCommitWriter(man, db, 50, 100, this);
+ *    QFuture<bool> future = writer->insertIntoTable("events", row);
+ *    // Later, e.g before the application quits
+ *    writer->flush();
+ * @endcode
+ */
+class SqliteGroupCommitWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Operation = std::function<bool(SqliteManager &manager, QSqlDatabase &database)>;
+
+public:
+    /**
+     * @param manager
+     * @param database
+     * @param flushInterval In milliseconds.
+     * @param maxOperationCount
+     * @param parent
+     */
+    SqliteGroupCommitWriter(SqliteManager &manager, const QSqlDatabase &database, int flushInterval = 50, int maxOperationCount = 100,
+                            QObject *parent = nullptr);
+    ~SqliteGroupCommitWriter();
+
+    /**
+     * @brief Queues the operation. If the queue is full, the group is flushed before this returns.
+     * @param operation Returns false If the write failed.
+     * @return QFuture<bool>
+     */
+    QFuture<bool> enqueue(const Operation &operation);
+
+    QFuture<bool> insertIntoTable(const QString &tableName, const QMap<QString, QVariant> &row);
+    QFuture<bool> upsertIntoTable(const QString &tableName, const QMap<QString, QVariant> &row, const QStringList &conflictColumns);
+    QFuture<bool> updateInTable(const QString &tableName, const QMap<QString, QVariant> &row, const SqliteWhere &where);
+    QFuture<bool> deleteInTable(const QString &tableName, const SqliteWhere &where);
+
+    /**
+     * @brief Commits the queued writes now. If a transaction is already open on the connection, the writes are not committed since the
+     * outer transaction could still roll them back. They stay queued and they are flushed after the next interval instead.
+     * @return bool Returns false If the group could not be committed or it is deferred. Returns true If there's nothing to commit.
+     */
+    bool flush();
+
+    int getPendingCount() const;
+
+signals:
+    /**
+     * @brief Emitted after every group.
+     * @param operationCount
+     * @param isCommitted
+     */
+    void flushed(int operationCount, bool isCommitted);
+
+private:
+    struct PendingOperation {
+        Operation operation;
+        QFutureInterface<bool> futureInterface;
+    };
+
+    SqliteManager &m_Manager;
+    QSqlDatabase m_Database;
+    const int m_MaxOperationCount;
+    QTimer m_FlushTimer;
+    QList<PendingOperation> m_PendingOperations;
+    // Set while the flush waits for an open transaction, the cap does not trigger a flush until the timer fires again.
+    bool m_IsFlushDeferred;
+};
+
+}
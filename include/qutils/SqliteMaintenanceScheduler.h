@@ -0,0 +1,84 @@
+#pragma once
+// Qt
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+// qutils
+#include "qutils/SqliteManager.h"
+
+namespace zmc
+{
+
+/**
+ * @brief The SqliteMaintenanceScheduler class keeps a database compact and its planner statistics fresh without getting in the way of
+ * the application. It checks periodically whether the connection is idle, and If it is, runs a short maintenance slice:
+ * - Free pages are given back to the file system with `PRAGMA incremental_vacuum` in small chunks until the time budget of the slice is
+ *   used up. This needs the database to be in INCREMENTAL auto vacuum mode, see SqliteManager::setAutoVacuum().
+ * - `PRAGMA optimize` is run every optimizeInterval.
+ * - ANALYZE is run every analyzeInterval with an analysis limit, so it stays short on large tables.
+ *
+ * The scheduler uses the given manager and connection on the thread it lives in.
+ * **Example Usage:**
+ * @code
+ *    man.setAutoVacuum(db, "INCREMENTAL");
+ *    SqliteMaintenanceScheduler *scheduler = new SqliteMaintenanceScheduler(man, db, SqliteMaintenanceScheduler::Options(), this);
+ *    scheduler->start();
+ * @endcode
+ */
+class SqliteMaintenanceScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        Options() = default;
+
+        // How often the connection is checked for idleness, in milliseconds.
+        int checkInterval = 30000;
+        // The connection is idle If no statement is executed for this long, in milliseconds.
+        int idleTime = 5000;
+        // Time budget of a single slice, in milliseconds. A chunk that is already started is not interrupted.
+        int sliceDuration = 50;
+        // Number of pages freed with a single incremental_vacuum.
+        int pagesPerChunk = 64;
+        // In milliseconds. Negative values disable the step.
+        qint64 optimizeInterval = 60 * 60 * 1000;
+        qint64 analyzeInterval = 24 * 60 * 60 * 1000;
+        int analysisLimit = 400;
+    };
+
+public:
+    SqliteMaintenanceScheduler(SqliteManager &manager, const QSqlDatabase &database, const Options &options = Options(),
+                               QObject *parent = nullptr);
+
+    void start();
+    void stop();
+    bool isActive() const;
+
+    /**
+     * @brief Runs a maintenance slice now, whether the connection is idle or not.
+     * @return bool Returns false If one of the steps failed.
+     */
+    bool runSlice();
+
+signals:
+    /**
+     * @brief Emitted after every slice.
+     * @param freedPageCount Number of pages freed in this slice.
+     * @param freelistCount Number of free pages left in the file.
+     */
+    void sliceFinished(int freedPageCount, int freelistCount);
+
+private:
+    SqliteManager &m_Manager;
+    QSqlDatabase m_Database;
+    const Options m_Options;
+    QTimer m_Timer;
+    // Invalid until the step is run for the first time.
+    QElapsedTimer m_OptimizeTimer, m_AnalyzeTimer;
+
+private:
+    void onTimeout();
+};
+
+}
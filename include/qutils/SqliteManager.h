@@ -2,13 +2,32 @@
 // Qt
 #include <QSqlDatabase>
 #include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
 #include <QVariantList>
+#include <QStringList>
+#include <QHash>
+#include <QSharedPointer>
+#include <QMutex>
+#include <QVector>
+#include <QIODevice>
+#include <QElapsedTimer>
+#include <QMetaObject>
+// qutils
+#include "qutils/SqliteResultSet.h"
+#include "qutils/SqliteWhere.h"
 // std
+#include <climits>
 #include <ostream>
+#include <functional>
+#include <list>
 
 namespace zmc
 {
 
+template<typename T>
+class SqliteTypedTable;
+
 class SqliteManager
 {
 public:
@@ -23,6 +42,13 @@ public:
         NONE
     };
 
+    enum class DataFormat {
+        // Comma separated values, RFC 4180 quoting.
+        CSV,
+        // Newline delimited JSON, one object per line.
+        NDJSON
+    };
+
     struct SelectOrder {
         enum class OrderType {
             ASC,
@@ -38,6 +64,7 @@ public:
         }
 
         OrderType order;
+        // Used in the ORDER BY clause as is, so it can be an expression like `lower(name)`. Quote it If it is not a plain name.
         QString fieldName;
     };
 
@@ -69,6 +96,114 @@ public:
         int column = 0, row = 0;
     };
 
+    struct IndexDefinition {
+        IndexDefinition() = default;
+        IndexDefinition(const QString &_name, const QString &_tableName, const QStringList &_columns, bool _isUnique = false,
+                        const QString &_whereClause = "")
+            : name(_name)
+            , tableName(_tableName)
+            , columns(_columns)
+            , isUnique(_isUnique)
+            , whereClause(_whereClause)
+        {}
+
+        QString name;
+        QString tableName;
+        // Column names or expressions, e.g "first", "second DESC" or "lower(name)". They are used as is.
+        QStringList columns;
+        bool isUnique = false;
+        // If it is not empty, the index is a partial index. e.g "deleted_at IS NULL"
+        QString whereClause;
+    };
+
+    /**
+     * @brief Definition of an FTS5 full-text table. If contentTableName is set, the table is an external content table: the text is
+     * only stored in the content table and the index is kept in sync with triggers on it.
+     */
+    struct FullTextTableDefinition {
+        FullTextTableDefinition() = default;
+        FullTextTableDefinition(const QString &_name, const QStringList &_columns, const QString &_contentTableName = "",
+                                const QString &_contentRowIDColumn = "rowid")
+            : name(_name)
+            , columns(_columns)
+            , contentTableName(_contentTableName)
+            , contentRowIDColumn(_contentRowIDColumn)
+        {}
+
+        QString name;
+        QStringList columns;
+        QString contentTableName;
+        // An INTEGER PRIMARY KEY column of the content table, or rowid.
+        QString contentRowIDColumn = "rowid";
+        // e.g "unicode61 remove_diacritics 2", "porter unicode61" or "trigram". If empty, the default tokenizer is used.
+        QString tokenizer;
+    };
+
+    struct SearchOptions {
+        SearchOptions() = default;
+
+        // Used for paging through the results.
+        int offset = 0;
+        // Index of the column the snippet is taken from, -1 picks the best matching column.
+        int snippetColumn = -1;
+        // Maximum number of tokens in the snippet, between 1 and 64.
+        int snippetTokenCount = 12;
+        QString highlightStart = "<b>";
+        QString highlightEnd = "</b>";
+        QString ellipsis = "...";
+    };
+
+    struct SearchHit {
+        SearchHit() = default;
+
+        qint64 rowID = 0;
+        // bm25 score, a smaller value is a better match.
+        double rank = 0.0;
+        QString snippet;
+        // Values of the columns of the full-text table.
+        QMap<QString, QVariant> columns;
+    };
+
+    /**
+     * @brief A row of `EXPLAIN QUERY PLAN`. The steps form a tree through parentID, the steps of the top level have a parentID of 0.
+     */
+    struct QueryPlanStep {
+        QueryPlanStep() = default;
+
+        int id = 0;
+        int parentID = 0;
+        // Distance to the top level.
+        int depth = 0;
+        QString detail;
+    };
+
+    struct QueryPlan {
+        QueryPlan() = default;
+
+        // Steps in the order SQLite reports them, children come after their parent.
+        QList<QueryPlanStep> steps;
+
+        QList<QueryPlanStep> getChildren(int parentID) const;
+
+        /**
+         * @brief Returns true If any of the steps searches a table using an index or the primary key.
+         * @return bool
+         */
+        bool isUsingIndex() const;
+
+        /**
+         * @brief Returns true If any of the steps scans a whole table without an index.
+         * @return bool
+         */
+        bool hasFullScan() const;
+
+        /**
+         * @brief Returns the plan as an indented tree like the sqlite3 shell prints it.
+         * @return QString
+         */
+        QString toString() const;
+    };
+
     struct SqliteError {
         SqliteError() = default;
 
@@ -82,21 +217,446 @@ public:
         }
     };
 
+    /**
+     * @brief A page returned by getPageFromTable().
+     */
+    struct Page {
+        Page() = default;
+
+        QList<QMap<QString, QVariant>> rows;
+        // Pass this to getPageFromTable() to get the next page. It is empty If there are no more rows.
+        QString continuationToken;
+        bool hasMore = false;
+    };
+
+    enum class AggregateFunction {
+        COUNT,
+        SUM,
+        // Same as SUM, but returns 0.0 instead of NULL when there are no rows.
+        TOTAL,
+        MIN,
+        MAX,
+        AVG
+    };
+
+    /**
+     * @brief A single aggregate column of aggregate(). If the column is empty, COUNT counts all rows.
+     */
+    struct Aggregate {
+        Aggregate() = default;
+
+        Aggregate(AggregateFunction _function, const QString &_column, const QString &_alias = QString(), bool _isDistinct = false)
+            : function(_function)
+            , column(_column)
+            , alias(_alias)
+            , isDistinct(_isDistinct)
+        {
+        }
+
+        AggregateFunction function = AggregateFunction::COUNT;
+        QString column;
+        // The key of the value in the result rows. If it is empty, e.g "sum_price" is used.
+        QString alias;
+        bool isDistinct = false;
+
+        QString getFunctionName() const;
+        QString getAlias() const;
+    };
+
+    struct StatementCacheStats {
+        StatementCacheStats() = default;
+
+        unsigned int hits = 0, misses = 0, evictions = 0;
+        int size = 0;
+    };
+
+    /**
+     * @brief Execution statistics of a single query shape. The literals in the query are replaced with ? and the whitespace is
+     * collapsed, so the same query with different values is counted once. The times are in microseconds. The latencies only cover the
+     * execution of the statement, the time spent on reading the rows of a select query is in fetchTime.
+     */
+    struct QueryStats {
+        QueryStats() = default;
+
+        QString query;
+        qint64 callCount = 0;
+        qint64 failedCount = 0;
+        qint64 totalTime = 0;
+        qint64 maxTime = 0;
+        // Calculated from the most recent executions.
+        qint64 p95Time = 0;
+        qint64 fetchTime = 0;
+        qint64 rowsReturned = 0;
+        qint64 rowsChanged = 0;
+
+        qint64 getMeanTime() const
+        {
+            return callCount > 0 ? totalTime / callCount : 0;
+        }
+
+        QVariantMap toMap() const;
+    };
+
+    /**
+     * @brief Called when a statement takes longer than the slow query threshold.
+     * @param query The query as it was executed.
+     * @param bindValues
+     * @param elapsed In microseconds.
+     */
+    using SlowQueryCallback = std::function<void(const QString &query, const QVariantList &bindValues, qint64 elapsed)>;
+
+    struct ResultCacheStats {
+        ResultCacheStats() = default;
+
+        qint64 hits = 0, misses = 0, invalidations = 0;
+        int entryCount = 0;
+        // Estimated size of the cached rows in bytes.
+        qint64 size = 0;
+    };
+
+    struct BatchResult {
+        BatchResult() = default;
+
+        bool isCommitted = false;
+        int insertedCount = 0;
+        // Index of the row in the batch -> The error that occurred while inserting that row.
+        QMap<int, QSqlError> failedRows;
+
+        bool isSuccessful() const
+        {
+            return isCommitted && failedRows.size() == 0;
+        }
+    };
+
+    struct ImportResult {
+        ImportResult() = default;
+
+        bool isCompleted = false;
+        bool isCancelled = false;
+        // Number of records that were read from the input, including the ones that failed.
+        qint64 readCount = 0;
+        qint64 insertedCount = 0;
+        qint64 bytesRead = 0;
+        // In milliseconds
+        qint64 elapsed = 0;
+        // Index of the record in the input, not counting the CSV header -> The error that occurred while parsing or inserting it.
+        QMap<qint64, QSqlError> failedRows;
+
+        bool isSuccessful() const
+        {
+            return isCompleted && failedRows.size() == 0;
+        }
+
+        double getRowsPerSecond() const
+        {
+            return elapsed > 0 ? insertedCount * 1000.0 / elapsed : 0.0;
+        }
+    };
+
+    struct ImportOptions {
+        ImportOptions() = default;
+
+        // Number of rows that are committed in one transaction.
+        int batchSize = 1000;
+        // CSV only. If empty, the first record is the header. Otherwise the first record is data and these are its column names.
+        QStringList csvColumnNames;
+        QChar csvDelimiter = ',';
+        // Sequential devices only (e.g QProcess or a socket). How long to wait for more data in milliseconds, -1 waits forever. The
+        // import ends when the device has no more data or the timeout expires.
+        int readTimeout = 30000;
+        // Called after every committed batch. Return false to stop the import, the batches that are already committed are kept.
+        std::function<bool(const ImportResult &progress)> progressCallback;
+    };
+
+    struct ExportOptions {
+        ExportOptions() = default;
+
+        // Compresses the output with gzip. Requires qutils to be built with zlib, see QUTILS_ZLIB.
+        bool isGzipEnabled = false;
+        // CSV only. Writes the column names as the first record.
+        bool hasCsvHeader = true;
+        QChar csvDelimiter = ',';
+    };
+
+    /**
+     * @brief Connection settings that are applied with PRAGMAs when a database is opened. Empty strings and UNSET values are left at
+     * the SQLite defaults. Use getPreset() for the named presets.
+     */
+    struct OpenOptions {
+        static const int UNSET = INT_MIN;
+
+        OpenOptions() = default;
+
+        QString presetName;
+        // DELETE, TRUNCATE, PERSIST, MEMORY, WAL or OFF
+        QString journalMode;
+        // OFF, NORMAL, FULL or EXTRA
+        QString synchronous;
+        // DEFAULT, FILE or MEMORY
+        QString tempStore;
+        // Positive values are in pages, negative values are in KiB.
+        int cacheSize = UNSET;
+        // Only takes effect before the database is created, or when it is vacuumed.
+        int pageSize = UNSET;
+        // In milliseconds
+        int busyTimeout = UNSET;
+        // 0 or 1
+        int foreignKeys = UNSET;
+        // In bytes. 0 disables memory mapped I/O, -1 means UNSET.
+        qint64 mmapSize = -1;
+        // NONE, FULL or INCREMENTAL. Only takes effect before the first table is created, use setAutoVacuum() for an existing database.
+        QString autoVacuum;
+
+        /**
+         * @brief Returns the options for the named preset:
+         * - "durable": WAL journal, synchronous=FULL and foreign keys. Nothing committed is lost even on a power failure.
+         * - "fast-cache": WAL journal, synchronous=OFF, a bigger page cache, temp tables in memory and incremental auto vacuum. For
+         *   databases whose content can be recreated, e.g a cache.
+         * - "read-mostly": WAL journal, synchronous=NORMAL, a big page cache and memory mapped I/O.
+         * For an unknown name, returns the default options which do not change anything.
+         * @param name
+         * @return OpenOptions
+         */
+        static OpenOptions getPreset(const QString &name);
+
+        QVariantMap toMap() const;
+    };
+
+    struct PageStats {
+        PageStats() = default;
+
+        // In bytes
+        int pageSize = 0;
+        int pageCount = 0;
+        // Number of unused pages in the file.
+        int freelistCount = 0;
+        // NONE, FULL or INCREMENTAL
+        QString autoVacuum;
+
+        qint64 getDatabaseSize() const
+        {
+            return static_cast<qint64>(pageSize) * pageCount;
+        }
+
+        qint64 getFreeSize() const
+        {
+            return static_cast<qint64>(pageSize) * freelistCount;
+        }
+
+        double getFreeRatio() const
+        {
+            return pageCount > 0 ? static_cast<double>(freelistCount) / pageCount : 0.0;
+        }
+    };
+
+    struct BackupProgress {
+        BackupProgress() = default;
+
+        int remainingPageCount = 0;
+        int totalPageCount = 0;
+
+        double getProgress() const
+        {
+            return totalPageCount > 0 ? 1.0 - static_cast<double>(remainingPageCount) / totalPageCount : 0.0;
+        }
+    };
+
+    /**
+     * @brief Called after every step of a backup. Return false to cancel the backup.
+     */
+    using BackupProgressCallback = std::function<bool(const BackupProgress &progress)>;
+
+    using ResultSet = SqliteResultSet;
+    using Where = SqliteWhere;
     using Constraint = std::tuple<QString/*columnName*/, QString/*value*/, QString/*AND|OR*/>;
 
+    /**
+     * @brief Forward-only cursor over the results of a select query. Use SqliteManager::openCursor() to create one.
+     */
+    class Cursor
+    {
+    public:
+        Cursor();
+        Cursor(Cursor &&other);
+        ~Cursor();
+
+        Cursor(const Cursor &other) = delete;
+        Cursor &operator=(const Cursor &other) = delete;
+        Cursor &operator=(Cursor &&other);
+
+        /**
+         * @brief Returns true If the query was executed successfully and the cursor is not closed.
+         * @return bool
+         */
+        bool isValid() const;
+
+        /**
+         * @brief Moves to the next row. Returns false when there are no more rows.
+         * @return bool
+         */
+        bool next();
+
+        /**
+         * @brief Resets the statement. The rest of the rows are not fetched.
+         */
+        void close();
+
+        int getColumnCount() const;
+        QStringList getColumnNames() const;
+
+        QVariant value(int columnIndex) const;
+        QVariant value(const QString &columnName) const;
+
+        /**
+         * @brief Returns the current row as a map.
+         * @return QMap<QString, QVariant>
+         */
+        QMap<QString, QVariant> getRow() const;
+
+    private:
+        friend class SqliteManager;
+
+        QSqlQuery m_Query;
+        QSqlRecord m_Record;
+        bool m_IsValid;
+        // Set when the query statistics are enabled, the fetched rows are reported to it when the cursor is closed.
+        SqliteManager *m_Manager;
+        QString m_SqlQueryStr;
+        qint64 m_RowCount;
+        // In nanoseconds
+        qint64 m_FetchTime;
+
+    private:
+        Cursor(const QSqlQuery &query, SqliteManager *manager = nullptr, const QString &sqlQueryStr = QString());
+    };
+
+    using RowCallback = std::function<bool(const Cursor &cursor)>;
+
+    /**
+     * @brief Scope guard for a transaction. The transaction is started in the constructor and rolled back in the destructor unless
+     * commit() is called, so an early return or an exception never leaves half of the changes in the database. Transactions can be
+     * nested, every level is a SAVEPOINT and only the outermost one makes the changes durable. The nesting is tracked per connection,
+     * so transactions of different managers that share the same connection nest as well.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    SqliteManager::Transaction transaction(man, db);
+     *    if (man.deleteInTable(db, "my_table", constraints) == false) {
+     *        return false; // Rolled back
+     *    }
+     *
+     *    man.insertIntoTable(db, "my_table", row);
+     *    return transaction.commit();
+     * @endcode
+     */
+    class Transaction
+    {
+    public:
+        Transaction(SqliteManager &manager, QSqlDatabase &database);
+        ~Transaction();
+
+        Transaction(const Transaction &other) = delete;
+        Transaction &operator=(const Transaction &other) = delete;
+
+        /**
+         * @brief Returns true If the transaction was started and it is not committed or rolled back yet.
+         * @return bool
+         */
+        bool isActive() const;
+
+        /**
+         * @brief Releases the savepoint. If this is the outermost transaction, the changes are committed. If it fails, the
+         * transaction is rolled back.
+         * @return bool
+         */
+        bool commit();
+
+        /**
+         * @brief Rolls back the changes made since the transaction started.
+         * @return bool
+         */
+        bool rollback();
+
+    private:
+        SqliteManager &m_Manager;
+        QSqlDatabase m_Database;
+        QString m_SavepointName;
+        bool m_IsActive;
+
+    private:
+        bool execute(const QString &sqlQueryStr);
+        void finish();
+    };
+
 public:
     SqliteManager();
 
+    /**
+     * @brief Returns true If a transaction is open on the connection. With QUTILS_SQLITE_NATIVE, sqlite itself is asked so every
+     * transaction is seen. Without it, only the Transactions are seen, including the ones of the other managers that use the same
+     * connection. A transaction started with QSqlDatabase::transaction() or a plain BEGIN is not visible in that case.
+     * @param database
+     * @return bool
+     */
+    bool isInTransaction(QSqlDatabase &database);
+
     /**
      * @brief Creates a sqlite3 instance and returns it. If there's an error, you can get the error with getLastError().
      * If another database with the same databasePath has been opened before, returns that database connection to avoid multiple connections to the same
      * database.
+     * The connection is named after the database path, so it can only be used from the thread that opened it first. Use
+     * SqliteConnectionPool for the connections of the other threads.
      * @param databasePath
      * @param createIfFileAbsent
      * @return QSqlDatabase
      */
     QSqlDatabase openDatabase(const QString &databasePath);
 
+    /**
+     * @brief Same as the other openDatabase(), but the connection is registered with the given name instead of the database path.
+     * Use this when you need more than one connection to the same database, e.g a connection that is used from another thread.
+     * @param databasePath
+     * @param connectionName
+     * @return QSqlDatabase
+     */
+    QSqlDatabase openDatabase(const QString &databasePath, const QString &connectionName);
+
+    /**
+     * @brief Opens the database and applies the given options. The options are applied one by one, If any of them fails the ones that
+     * are already applied are set back to their previous values. The connection is shared with the other managers that open the same
+     * path, so it stays open even If the options fail. The values that are in effect after opening are written to `appliedOptions`, so
+     * different presets can be compared.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    SqliteManager::OpenOptions applied;
+     *    QSqlDatabase db = man.openDatabase(path, SqliteManager::OpenOptions::getPreset("fast-cache"), &applied);
+     *    qDebug() << applied.toMap();
+     * @endcode
+     * @param databasePath
+     * @param options
+     * @param appliedOptions Can be nullptr.
+     * @param ok Set to false If the database cannot be opened or the options cannot be applied. Can be nullptr.
+     * @return QSqlDatabase
+     */
+    QSqlDatabase openDatabase(const QString &databasePath, const OpenOptions &options, OpenOptions *appliedOptions = nullptr,
+                              bool *ok = nullptr);
+
+    /**
+     * @brief Applies the options to an open connection. See openDatabase().
+     * @param database
+     * @param options
+     * @return bool Returns false If one of the options cannot be applied. The options that were applied before it are restored.
+     */
+    bool applyOpenOptions(QSqlDatabase &database, const OpenOptions &options);
+
+    /**
+     * @brief Reads the current values of the options from the connection.
+     * @param database
+     * @return OpenOptions
+     */
+    OpenOptions readOpenOptions(QSqlDatabase &database);
+
     /**
      * @brief Closes the given database
      * @param database
@@ -104,6 +664,43 @@ public:
      */
     void closeDatabase(QSqlDatabase &database);
 
+    /**
+     * @brief Copies the database to `destinationPath` with the SQLite online backup API while it is in use. `pagesPerStep` pages are
+     * copied at a time and the source is only locked during a step, so the other connections can read from and write to it between
+     * the steps. If the source is written to by another connection, the backup starts over with the next step. The changes made through
+     * `source` itself are copied along.
+     *
+     * The backup is written next to the destination and moved to it when it is complete, so an existing file is only replaced by a
+     * complete backup. This blocks the calling thread, use SqliteAsyncExecutor::backup() to run it on a worker thread.
+     *
+     * The backup API needs qutils to be built with QUTILS_SQLITE_NATIVE (see SqliteBlobDevice). Without it, the snapshot is taken with
+     * vacuumInto() instead, which copies the database in one step.
+     * **Example Usage:**
+     * @code
+     *    man.backup(db, backupPath, 256, [](const SqliteManager::BackupProgress &progress) {
+     *        qDebug() << progress.getProgress();
+     *        return true;
+     *    });
+     * @endcode
+     * @param source
+     * @param destinationPath
+     * @param pagesPerStep If it is less than 1, the database is copied in a single step.
+     * @param callback Can be empty.
+     * @param sleepBetweenSteps In milliseconds. Gives the other connections time to use the database between the steps.
+     * @return bool
+     */
+    bool backup(QSqlDatabase &source, const QString &destinationPath, int pagesPerStep = 100,
+                const BackupProgressCallback &callback = BackupProgressCallback(), int sleepBetweenSteps = 10);
+
+    /**
+     * @brief Writes a compacted copy of the database to `destinationPath` with `VACUUM INTO`. The copy has no free pages and it is
+     * consistent even while the database is written to. Requires SQLite 3.27. It cannot be called inside a transaction.
+     * @param source
+     * @param destinationPath
+     * @return bool
+     */
+    bool vacuumInto(QSqlDatabase &source, const QString &destinationPath);
+
     /**
      * @brief createTable
      * **Example Usage:**
@@ -131,6 +728,22 @@ public:
      */
     bool isTableExist(QSqlDatabase &database, const QString &tableName);
 
+    /**
+     * @brief Returns the column definitions of the given table. The definitions are read from the schema cache, and loaded with
+     * `PRAGMA table_info` the first time they are requested. If the table does not exist, returns an empty list.
+     * @param database
+     * @param tableName
+     * @return QList<ColumnDefinition>
+     */
+    QList<ColumnDefinition> getTableColumns(QSqlDatabase &database, const QString &tableName);
+
+    /**
+     * @brief Drops the cached schema of the given connection. The schema is reloaded with the next operation. You do not need to call
+     * this after schema changes made from another connection, those are detected with `PRAGMA schema_version`.
+     * @param database
+     */
+    void invalidateSchemaCache(const QSqlDatabase &database);
+
     /**
      * @brief Deletes the given table from the database
      * @param database
@@ -139,6 +752,111 @@ public:
      */
     bool dropTable(QSqlDatabase &database, const QString &tableName);
 
+    /**
+     * @brief Creates an index. Composite, unique, partial and expression indexes are supported through IndexDefinition.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    man.createIndex(db, SqliteManager::IndexDefinition("cache_name_index", "cache", {"cache_name"}, true));
+     *    man.createIndex(db, SqliteManager::IndexDefinition("active_users", "users", {"lower(name)", "age DESC"}, false, "deleted = 0"));
+     * @endcode
+     * @param database
+     * @param index
+     * @param ifNotExists If true, it is not an error when an index with the same name exists.
+     * @return bool
+     */
+    bool createIndex(QSqlDatabase &database, const IndexDefinition &index, bool ifNotExists = true);
+
+    /**
+     * @brief Deletes the index with the given name.
+     * @param database
+     * @param indexName
+     * @param ifExists If true, it is not an error when the index does not exist.
+     * @return bool
+     */
+    bool dropIndex(QSqlDatabase &database, const QString &indexName, bool ifExists = true);
+    bool hasIndex(QSqlDatabase &database, const QString &indexName);
+
+    /**
+     * @brief Returns the plan SQLite uses for the given query, without executing it. This is useful to make sure hot queries use an
+     * index.
+     * **Example Usage:**
+     * @code
+     *    const SqliteManager::QueryPlan plan = man.explainQueryPlan(db, "SELECT * FROM cache WHERE cache_name = ?");
+     *    Q_ASSERT(plan.isUsingIndex());
+     *    qDebug() << plan.toString();
+     * @endcode
+     * @param database
+     * @param sqlQueryStr
+     * @param bindValues Values for the positional placeholders. Unbound placeholders are NULL.
+     * @return QueryPlan If the query cannot be explained, the plan is empty.
+     */
+    QueryPlan explainQueryPlan(QSqlDatabase &database, const QString &sqlQueryStr, const QVariantList &bindValues = QVariantList());
+
+    /**
+     * @brief Creates an FTS5 table. For an external content table, the triggers that keep the index in sync with the content table are
+     * created as well and the existing rows of the content table are indexed. Everything is done in a single transaction.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    SqliteManager::FullTextTableDefinition definition("notes_fts", {"title", "body"}, "notes", "id");
+     *    definition.tokenizer = "unicode61 remove_diacritics 2";
+     *    man.createFullTextTable(db, definition);
+     *    const QList<SqliteManager::SearchHit> hits = man.search(db, "notes_fts", SqliteManager::toFullTextQuery("quick fox", true), 20);
+     * @endcode
+     * @param database
+     * @param definition
+     * @return bool
+     */
+    bool createFullTextTable(QSqlDatabase &database, const FullTextTableDefinition &definition);
+
+    /**
+     * @brief Drops the FTS5 table and, for an external content table, its triggers. The content table is not changed.
+     * @param database
+     * @param definition
+     * @return bool
+     */
+    bool dropFullTextTable(QSqlDatabase &database, const FullTextTableDefinition &definition);
+
+    /**
+     * @brief Rebuilds the index of the FTS5 table from its content. Use this when the content table was changed while the triggers
+     * did not exist.
+     * @param database
+     * @param tableName
+     * @return bool
+     */
+    bool rebuildFullTextTable(QSqlDatabase &database, const QString &tableName);
+
+    /**
+     * @brief Merges the b-trees of the FTS5 index into one, which makes the queries faster. It can take a while on large tables.
+     * @param database
+     * @param tableName
+     * @return bool
+     */
+    bool optimizeFullTextTable(QSqlDatabase &database, const QString &tableName);
+
+    /**
+     * @brief Runs the FTS5 `query` on the table and returns the hits ordered by their bm25 rank, the best match is the first. The query
+     * uses the FTS5 query syntax, use toFullTextQuery() for user input.
+     * @param database
+     * @param tableName
+     * @param query
+     * @param limit
+     * @param options
+     * @return QList<SearchHit>
+     */
+    QList<SearchHit> search(QSqlDatabase &database, const QString &tableName, const QString &query, int limit = 20,
+                            const SearchOptions &options = SearchOptions());
+
+    /**
+     * @brief Converts free text to an FTS5 query that matches the rows containing all of the words. Every word is quoted, so the
+     * characters that have a meaning in the FTS5 syntax are searched as they are.
+     * @param text
+     * @param isPrefixMatch If true, the last word also matches the words that start with it. Useful for search-as-you-type.
+     * @return QString
+     */
+    static QString toFullTextQuery(const QString &text, bool isPrefixMatch = false);
+
     /**
      * @brief Constructs a string for the WHERE queries.
      * @param values - It's a tuple where item:
@@ -157,31 +875,89 @@ public:
      *    std::cerr << man.constructWhereQuery(values) << std::endl;
      *    // Output is: WHERE first=1 AND second=1
      * @endcode
+     * The values are spliced into the query, the query helpers of SqliteManager use Where instead which binds the values.
      * @return QString Returns the query WITHOUT the WHERE clause
      */
     QString constructWhereQuery(const QList<Constraint> &values);
 
     /**
-     * @brief Executes the given query and if it is successful iterates through the results and calls the `callback` in each step.
-     * You can then use the `sqlite3_stmt` to get the value of the column. You can either provide the `callback` here, or you can use
-     * `onRowProcessed` callback. The iteration will continue as long as the `callback` returns `true`, if it returns `false` the operation
-     * will be terminated.
-     * @param database
-     * @param query
-     * @param callback
+     * @brief Executes a statement that does not return rows, e.g an UPDATE, an INSERT ... SELECT or an ALTER TABLE. The statement is
+     * prepared through the statement cache. After a CREATE, ALTER or DROP statement the schema cache is invalidated.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    int rowsChanged = 0;
+     *    man.executeQuery(db, "UPDATE my_table SET second = second + 1 WHERE first > ?", {10}, &rowsChanged);
+     * @endcode
+     * @param database
+     * @param sqlQueryStr
+     * @param bindValues
+     * @param rowsChanged Set to the number of rows changed by the statement. Can be nullptr.
+     * @return bool
+     */
+    bool executeQuery(QSqlDatabase &database, const QString &sqlQueryStr, const QVariantList &bindValues = QVariantList(),
+                      int *rowsChanged = nullptr);
+
+    /**
+     * @brief Executes the given query and returns all of the rows. Every row is copied into a map, so for large results use
+     * forEachRow() or openCursor() which do not keep the rows in memory.
+     * @param database
+     * @param sqlQueryStr
      *
      * **Example Usage:**
      * @code
      *    SqliteManager man;
-     *    sqlite3 *db = man.openDatabase("C:/Users/Furkanzmc/Desktop/test.sqlite");
+     *    QSqlDatabase db = man.openDatabase("C:/Users/Furkanzmc/Desktop/test.sqlite");
      *    const QString query = "SELECT * from new_table_2";
-     *    const QVariantList data = man.executeSelectQuery(db, query);
+     *    const QList<QMap<QString, QVariant>> data = man.executeSelectQuery(db, query);
      *    qDebug() << data;
      * @endcode
      * @return QList<QMap<QString, QVariant>>
      */
     QList<QMap<QString, QVariant>> executeSelectQuery(QSqlDatabase &database, const QString &sqlQueryStr);
 
+    /**
+     * @brief Executes the given query and stores the rows in the columnar `resultSet`. The result set is cleared first.
+     * @param database
+     * @param sqlQueryStr
+     * @param resultSet
+     * @param bindValues Values for the positional placeholders in the query.
+     * @return bool Returns false If the query fails.
+     */
+    bool executeSelectQuery(QSqlDatabase &database, const QString &sqlQueryStr, ResultSet &resultSet,
+                            const QVariantList &bindValues = QVariantList());
+
+    /**
+     * @brief Executes the given query and returns a forward-only cursor over the results. Rows are fetched from sqlite one at a time
+     * as next() is called, so the memory usage does not depend on the number of rows. The statement is reset when the cursor is
+     * destroyed or closed.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    SqliteManager::Cursor cursor = man.openCursor(db, "SELECT * FROM my_table WHERE first > ?", QVariantList{10});
+     *    while (cursor.next()) {
+     *        qDebug() << cursor.value("second");
+     *    }
+     * @endcode
+     * @param database
+     * @param sqlQueryStr
+     * @param bindValues Values for the positional placeholders in the query.
+     * @return Cursor If the query fails, the cursor is not valid.
+     */
+    Cursor openCursor(QSqlDatabase &database, const QString &sqlQueryStr, const QVariantList &bindValues = QVariantList());
+
+    /**
+     * @brief Executes the given query and calls `callback` for each row. The iteration continues as long as the `callback` returns
+     * `true`, if it returns `false` the iteration is terminated and the rest of the rows are never fetched.
+     * @param database
+     * @param sqlQueryStr
+     * @param callback
+     * @param bindValues Values for the positional placeholders in the query.
+     * @return bool Returns false If the query fails.
+     */
+    bool forEachRow(QSqlDatabase &database, const QString &sqlQueryStr, const RowCallback &callback,
+                    const QVariantList &bindValues = QVariantList());
+
     /**
      * @brief Executes a select query with the given constraints on the given table. If it succeeds,
      * the table data is returned as a QList<QMap<QString, QVariant>>.
@@ -197,7 +973,146 @@ public:
                                 const SelectOrder *selectOrder = nullptr);
 
     /**
-     * @brief Insert row(s) into the given table.
+     * @brief Same as the other getFromTable(), but the rows are stored in the columnar `resultSet` which stores the column names once
+     * and the values in per column vectors.
+     * @param database
+     * @param tableName
+     * @param resultSet
+     * @param limit
+     * @param constraints
+     * @param selectOrder
+     * @return bool Returns false If the query fails.
+     */
+    bool getFromTable(QSqlDatabase &database, const QString &tableName, ResultSet &resultSet, const unsigned int &limit = -1,
+                      const QList<Constraint> *constraints = nullptr, const SelectOrder *selectOrder = nullptr);
+
+    /**
+     * @brief Executes a select query filtered with `where`. The values of `where` are bound to the statement, so the same filter
+     * shape reuses the same prepared statement.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    SqliteManager::Where where;
+     *    where.where("first", SqliteManager::Where::Operator::GREATER_OR_EQUAL, 10);
+     *    const QList<QMap<QString, QVariant>> rows = man.getFromTable(db, "my_table", where);
+     * @endcode
+     * @param database
+     * @param tableName
+     * @param where
+     * @param limit
+     * @param selectOrder If it is empty, it is ignored.
+     * @return QList<QMap<QString, QVariant>>
+     */
+    QList<QMap<QString, QVariant>> getFromTable(QSqlDatabase &database, const QString &tableName, const Where &where,
+                                                const unsigned int &limit = -1, const SelectOrder *selectOrder = nullptr);
+    bool getFromTable(QSqlDatabase &database, const QString &tableName, ResultSet &resultSet, const Where &where,
+                      const unsigned int &limit = -1, const SelectOrder *selectOrder = nullptr);
+
+    /**
+     * @brief Same as the other getFromTable(), but only the given `columns` are selected. The other columns are neither read by SQLite
+     * nor converted to QVariant. If `columns` is empty, all of the columns are selected.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    const QList<QMap<QString, QVariant>> rows = man.getFromTable(db, "messages", {"id", "title"}, where);
+     * @endcode
+     * @param database
+     * @param tableName
+     * @param columns
+     * @param where
+     * @param limit
+     * @param selectOrder If it is empty, it is ignored.
+     * @return QList<QMap<QString, QVariant>>
+     */
+    QList<QMap<QString, QVariant>> getFromTable(QSqlDatabase &database, const QString &tableName, const QStringList &columns,
+                                                const Where &where = Where(), const unsigned int &limit = -1,
+                                                const SelectOrder *selectOrder = nullptr);
+    bool getFromTable(QSqlDatabase &database, const QString &tableName, ResultSet &resultSet, const QStringList &columns,
+                      const Where &where = Where(), const unsigned int &limit = -1, const SelectOrder *selectOrder = nullptr);
+
+    /**
+     * @brief Computes the aggregates in SQLite and returns one row per group. Each row contains the `groupBy` columns and the aggregates
+     * under their aliases. Without `groupBy`, a single row is returned for the whole table.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    SqliteManager::Where having;
+     *    having.where("order_count", SqliteWhere::Operator::GREATER, 10);
+     *    const QList<QMap<QString, QVariant>> rows = man.aggregate(db, "orders", {
+     *        SqliteManager::Aggregate(SqliteManager::AggregateFunction::COUNT, "", "order_count"),
+     *        SqliteManager::Aggregate(SqliteManager::AggregateFunction::SUM, "price")
+     *    }, {"customer_id"}, SqliteManager::Where(), having);
+     *    // Every row has "customer_id", "order_count" and "sum_price".
+     * @endcode
+     * @param database
+     * @param tableName
+     * @param aggregates
+     * @param groupBy
+     * @param where Filters the rows before they are grouped.
+     * @param having Filters the groups. Its column names refer to the group columns or the aliases of the aggregates.
+     * @param selectOrder Can order by a group column or an alias. If it is empty, it is ignored.
+     * @param limit
+     * @return QList<QMap<QString, QVariant>> If there's an error, the list is empty.
+     */
+    QList<QMap<QString, QVariant>> aggregate(QSqlDatabase &database, const QString &tableName, const QList<Aggregate> &aggregates,
+                                             const QStringList &groupBy = QStringList(), const Where &where = Where(),
+                                             const Where &having = Where(), const SelectOrder *selectOrder = nullptr,
+                                             const unsigned int &limit = -1);
+
+    /**
+     * @brief Returns a single aggregate of the rows that match `where`, e.g the sum of a column.
+     * @param database
+     * @param tableName
+     * @param function
+     * @param column If it is empty, COUNT counts all rows.
+     * @param where
+     * @param isDistinct
+     * @return QVariant If there's an error, returns an invalid QVariant. SUM, MIN, MAX and AVG return NULL when no rows match.
+     */
+    QVariant aggregateValue(QSqlDatabase &database, const QString &tableName, AggregateFunction function, const QString &column,
+                            const Where &where = Where(), bool isDistinct = false);
+
+    /**
+     * @brief Returns the number of rows that match `where`, or -1 If there's an error.
+     * @param database
+     * @param tableName
+     * @param where
+     * @return qint64
+     */
+    qint64 count(QSqlDatabase &database, const QString &tableName, const Where &where = Where());
+
+    /**
+     * @brief Returns a page of rows ordered by `sortColumns` using keyset pagination. Instead of OFFSET, the next page continues after
+     * the sort key of the last row of the previous page: `WHERE (a, b) > (?, ?) ORDER BY a, b LIMIT n`. So with an index on the sort
+     * columns, every page costs the same no matter how deep it is.
+     *
+     * The sort key must be unique and NOT NULL, otherwise rows can be skipped. Add a unique column (e.g the primary key) as the last
+     * sort column If the others are not unique.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    QString token;
+     *    do {
+     *        const SqliteManager::Page page = man.getPageFromTable(db, "messages", {"created_at", "id"}, 50, token);
+     *        process(page.rows);
+     *        token = page.continuationToken;
+     *    } while (token.isEmpty() == false);
+     * @endcode
+     * @param database
+     * @param tableName
+     * @param sortColumns
+     * @param pageSize
+     * @param continuationToken Empty for the first page.
+     * @param where Additional filter, it must be the same for all of the pages.
+     * @param order Applies to all of the sort columns.
+     * @return Page If the token is not valid for the given sort columns or there's an error, the page is empty.
+     */
+    Page getPageFromTable(QSqlDatabase &database, const QString &tableName, const QStringList &sortColumns, int pageSize,
+                          const QString &continuationToken = QString(), const Where &where = Where(),
+                          SelectOrder::OrderType order = SelectOrder::OrderType::ASC);
+
+    /**
+     * @brief Insert row(s) into the given table. For large BLOBs, see SqliteBlobDevice which streams the data in chunks instead.
      * **Example Usage:**
      * @code
      *    qutils::SqliteManager man;
@@ -226,6 +1141,142 @@ public:
      */
     bool insertIntoTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row);
 
+    /**
+     * @brief Inserts all of the given rows in a single transaction. The insert statement is prepared once for every distinct set of
+     * columns and reused for the rest of the rows. A failing row does not abort the batch, its error is reported in the result and
+     * the remaining rows are still inserted. If a transaction is already active on the connection, the rows become part of it.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    QList<QMap<QString, QVariant>> rows;
+     *    for (int i = 0; i < 50000; i++) {
+     *        QMap<QString, QVariant> map;
+     *        map["first"] = i;
+     *        map["second"] = i * 2;
+     *        rows.append(map);
+     *    }
+     *
+     *    const SqliteManager::BatchResult result = man.insertManyIntoTable(db, "my_table", rows);
+     *    qDebug() << result.insertedCount << result.failedRows.keys();
+     * @endcode
+     * @param database
+     * @param tableName
+     * @param rows
+     * @return BatchResult
+     */
+    BatchResult insertManyIntoTable(QSqlDatabase &database, const QString &tableName, const QList<QMap<QString, QVariant>> &rows);
+
+    /**
+     * @brief Columnar variant of insertManyIntoTable(). `columnValues` must have one value list for every column in `columnNames`,
+     * and all of the value lists must have the same size. Row N is made of the Nth value of every list.
+     * @param database
+     * @param tableName
+     * @param columnNames
+     * @param columnValues
+     * @return BatchResult
+     */
+    BatchResult insertManyIntoTable(QSqlDatabase &database, const QString &tableName, const QStringList &columnNames,
+                                    const QList<QVariantList> &columnValues);
+
+    /**
+     * @brief Reads the records from `device` and inserts them into the table. The input is parsed one record at a time and only a
+     * single batch of rows is kept in memory, so the size of the input does not matter. Every batch is inserted with
+     * insertManyIntoTable() in its own transaction.
+     *
+     * For NDJSON, the keys of every object are the column names, nested objects and arrays are stored as JSON text. For CSV, all of the
+     * values are inserted as text and the column affinity of the table converts them.
+     * **Example Usage:**
+     * @code
+     *    QFile file("seed.csv");
+     *    file.open(QIODevice::ReadOnly);
+     *    SqliteManager::ImportOptions options;
+     *    options.progressCallback = [](const SqliteManager::ImportResult &progress) {
+     *        qDebug() << progress.insertedCount << progress.getRowsPerSecond();
+     *        return true;
+     *    };
+     *
+     *    const SqliteManager::ImportResult result = man.importFrom(db, &file, SqliteManager::DataFormat::CSV, "my_table",
+     *        {{"Name", "name"}, {"Age", "age"}}, options);
+     * @endcode
+     * @param database
+     * @param device Must be open for reading. Sequential devices are read until they have no more data, see ImportOptions::readTimeout.
+     * @param format
+     * @param tableName
+     * @param columnMapping Input field name -> Column name. If it is not empty, the fields that are not in the mapping are skipped.
+     * @param options
+     * @return ImportResult
+     */
+    ImportResult importFrom(QSqlDatabase &database, QIODevice *device, DataFormat format, const QString &tableName,
+                            const QMap<QString, QString> &columnMapping = QMap<QString, QString>(),
+                            const ImportOptions &options = ImportOptions());
+
+    /**
+     * @brief Runs the select query and writes its results to `device` one row at a time, so the memory use does not depend on the number
+     * of rows. BLOB values are written as base64 text and NULL values are written as null in NDJSON, and as empty fields in CSV.
+     * **Example Usage:**
+     * @code
+     *    QFile file("diagnostics.ndjson.gz");
+     *    file.open(QIODevice::WriteOnly);
+     *    SqliteManager::ExportOptions options;
+     *    options.isGzipEnabled = true;
+     *    qint64 exportedCount = 0;
+     *    man.exportTo(db, &file, SqliteManager::DataFormat::NDJSON, "SELECT * FROM logs WHERE level >= ?", {2}, options, &exportedCount);
+     * @endcode
+     * @param database
+     * @param device Must be open for writing. It is not closed.
+     * @param format
+     * @param sqlQueryStr
+     * @param bindValues
+     * @param options
+     * @param exportedCount Set to the number of rows written. Can be nullptr.
+     * @return bool Returns false If the query fails or the device cannot be written to.
+     */
+    bool exportTo(QSqlDatabase &database, QIODevice *device, DataFormat format, const QString &sqlQueryStr,
+                  const QVariantList &bindValues = QVariantList(), const ExportOptions &options = ExportOptions(),
+                  qint64 *exportedCount = nullptr);
+
+    /**
+     * @brief Inserts the row, or updates the existing row If it conflicts with a row on `conflictColumns`. This is a single
+     * `INSERT ... ON CONFLICT DO UPDATE` statement, so there's no need to read the row first. There must be a unique index or a
+     * primary key on `conflictColumns`.
+     *
+     * SQLite cannot return the previous values from the same statement. If `oldRow` is given, the existing row is read first and both
+     * statements are run in one transaction, so only pass it when the previous values are actually needed. If `returnedRow` is given,
+     * the row is returned as it is after the upsert with RETURNING, or with a SELECT after the upsert before SQLite 3.35.
+     *
+     * ON CONFLICT requires SQLite 3.24. With older versions, e.g the SQLite bundled with an older Qt, the row is looked up first and then
+     * updated or inserted in one transaction.
+     * **Example Usage:**
+     * @code
+     *    SqliteManager man;
+     *    QMap<QString, QVariant> row;
+     *    row["cache_name"] = "token";
+     *    row["cache_value"] = "abc";
+     *    QMap<QString, QVariant> oldRow;
+     *    man.upsertIntoTable(db, "cache", row, {"cache_name"}, {}, &oldRow);
+     * @endcode
+     * @param database
+     * @param tableName
+     * @param row
+     * @param conflictColumns
+     * @param updateColumns Columns that are updated on a conflict. If empty, all of the columns of `row` except the conflict columns
+     * are updated. If there are no such columns, the existing row is left as it is.
+     * @param oldRow If the row existed, set to its previous values. Otherwise set to an empty map. Can be nullptr.
+     * @param returnedRow Set to the values of the row after the upsert. Can be nullptr.
+     * @return bool
+     */
+    bool upsertIntoTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row,
+                         const QStringList &conflictColumns, const QStringList &updateColumns = QStringList(),
+                         QMap<QString, QVariant> *oldRow = nullptr, QMap<QString, QVariant> *returnedRow = nullptr);
+
+    /**
+     * @brief Returns the version of the SQLite library the connection uses in the same format as SQLITE_VERSION_NUMBER, e.g 3024000 for
+     * 3.24.0. It is read once per connection.
+     * @param database
+     * @return int Returns 0 If the version cannot be read.
+     */
+    int getSqliteVersion(QSqlDatabase &database);
+
     /**
      * @brief Update the data in table with the new data.
      * @param database
@@ -235,6 +1286,7 @@ public:
      * @return
      */
     bool updateInTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row, const QList<Constraint> &constraints);
+    bool updateInTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row, const Where &where);
 
     /**
      * @brief Deletes the records in the table acording to the given constraints. If constraints have a size of 0, then everythin is deleted.
@@ -244,6 +1296,7 @@ public:
      * @return
      */
     bool deleteInTable(QSqlDatabase &database, const QString &tableName, const QList<Constraint> &constraints);
+    bool deleteInTable(QSqlDatabase &database, const QString &tableName, const Where &where);
 
     /**
      * @brief Returns true If a row with the given constraints exists.
@@ -252,17 +1305,485 @@ public:
      * @return
      */
     bool exists(QSqlDatabase &database, const QString &tableName, const QList<Constraint> &constraints);
+    bool exists(QSqlDatabase &database, const QString &tableName, const Where &where);
 
     const SqliteError &getLastError() const;
 
     QString getColumnTypeName(const ColumnTypes &type) const;
     ColumnTypes getColumnType(const QString &typeName) const;
 
+    /**
+     * @brief Returns the page counts of the database file. If the database is not open, the counts are 0.
+     * @param database
+     * @return PageStats
+     */
+    PageStats getPageStats(QSqlDatabase &database);
+
+    /**
+     * @brief Changes the auto vacuum mode of the database. If the database already has tables, the mode only takes effect after a
+     * VACUUM, which rebuilds the whole file. So the database is vacuumed when the mode changes. It cannot be called inside a transaction.
+     * @param database
+     * @param mode NONE, FULL or INCREMENTAL
+     * @return bool
+     */
+    bool setAutoVacuum(QSqlDatabase &database, const QString &mode);
+
+    /**
+     * @brief Moves up to `pageCount` free pages to the end of the file and truncates it. Only works in INCREMENTAL auto vacuum mode.
+     * @param database
+     * @param pageCount If it is less than 1, all of the free pages are removed.
+     * @return int Number of pages removed, or -1 on error.
+     */
+    int incrementalVacuum(QSqlDatabase &database, int pageCount);
+
+    /**
+     * @brief Runs `PRAGMA optimize`, which analyzes the tables whose statistics are likely to be outdated. It is cheap and it is safe to
+     * call it periodically.
+     * @param database
+     * @return bool
+     */
+    bool optimize(QSqlDatabase &database);
+
+    /**
+     * @brief Collects the statistics of all of the tables and indexes for the query planner with ANALYZE.
+     * @param database
+     * @param analysisLimit If it is greater than 0, at most this many rows of each index are looked at, which keeps the run short on
+     * large tables. Requires SQLite 3.32.
+     * @return bool
+     */
+    bool analyze(QSqlDatabase &database, int analysisLimit = 0);
+
+    /**
+     * @brief Returns the time in milliseconds since the last statement was executed on the connection by any of the managers, or -1 If no
+     * statement is executed yet. The statements executed while the activity tracking is disabled are not counted.
+     * @param database
+     * @return qint64
+     */
+    qint64 getIdleTime(const QSqlDatabase &database) const;
+
+    /**
+     * @brief When disabled, the statements executed by this manager do not reset the idle time of the connection. SqliteMaintenanceScheduler
+     * disables it while it runs, so the maintenance itself does not keep the connection busy. Enabled by default.
+     * @param isTracked
+     */
+    void setActivityTracked(bool isTracked);
+    bool isActivityTracked() const;
+
+    /**
+     * @brief Sets the maximum number of prepared statements that are kept for each connection. When the limit is reached, the least
+     * recently used statement is evicted. Setting the capacity to 0 disables the statement cache. Default capacity is 32.
+     * @param capacity
+     */
+    void setStatementCacheCapacity(int capacity);
+    int getStatementCacheCapacity() const;
+
+    /**
+     * @brief Returns the hit/miss counters of the prepared statement cache for the given connection.
+     * @param database
+     * @return StatementCacheStats
+     */
+    StatementCacheStats getStatementCacheStats(const QSqlDatabase &database) const;
+
+    /**
+     * @brief Finalizes all of the cached prepared statements for the given connection.
+     * @param database
+     */
+    void clearStatementCache(const QSqlDatabase &database);
+
+    /**
+     * @brief Sets the maximum estimated size in bytes of the rows that are cached for each connection by getFromTable(). The results are
+     * keyed by the query and its bound values, and the least recently used results are evicted first. Setting the capacity to 0
+     * disables the result cache, which is the default.
+     *
+     * The cached results belong to the connection and they are shared by all of the managers that use it, the capacity of the manager
+     * that caches a result is applied. The cached results of a table are dropped when the table is written to with the write helpers of
+     * any of these managers. A write made
+     * by another connection drops all of the cached results, it is detected with `PRAGMA data_version`. It is checked once per
+     * transaction, or once per pass of the event loop when the thread runs one, otherwise on every lookup. With QUTILS_SQLITE_NATIVE,
+     * the SQLite update hook also drops the results of the tables that are changed by any other statement on this connection, e.g by
+     * a trigger. Without it, the write helpers and a successful executeQuery() drop all of the cached results of the connection, since
+     * the changes made by the triggers cannot be tracked.
+     * @param capacity
+     */
+    void setResultCacheCapacity(qint64 capacity);
+    qint64 getResultCacheCapacity() const;
+    ResultCacheStats getResultCacheStats(const QSqlDatabase &database) const;
+
+    /**
+     * @brief Drops the cached results of the given table, or all of the cached results of the connection If the table name is empty.
+     * Call this after changing a table with a query that does not go through the write helpers.
+     * @param database
+     * @param tableName
+     */
+    void invalidateResultCache(const QSqlDatabase &database, const QString &tableName = QString());
+
+    /**
+     * @brief Enables or disables the collection of the query statistics. Enabled by default.
+     * @param enabled
+     */
+    void setQueryStatsEnabled(bool enabled);
+    bool isQueryStatsEnabled() const;
+
+    /**
+     * @brief Returns the statistics of every query shape executed by this manager, sorted by the total time in descending order.
+     * @return QList<QueryStats>
+     */
+    QList<QueryStats> getQueryStats() const;
+
+    /**
+     * @brief Returns getQueryStats() as a JSON array.
+     * @return QByteArray
+     */
+    QByteArray getQueryStatsJson() const;
+    void resetQueryStats();
+
+    /**
+     * @brief Statements that take at least `milliseconds` to execute are reported to the slow query callback, or logged with their bound
+     * values If there's no callback. A negative threshold disables the slow query reporting, which is the default.
+     * @param milliseconds
+     */
+    void setSlowQueryThreshold(int milliseconds);
+    int getSlowQueryThreshold() const;
+    void setSlowQueryCallback(const SlowQueryCallback &callback);
+
 private:
+    // The typed tables prepare their statements once and bind the rows to them.
+    template<typename T>
+    friend class SqliteTypedTable;
+
+    struct StatementCacheEntry {
+        QSqlQuery query;
+        // Position of the key in StatementCache::usageOrder.
+        std::list<QString>::iterator usageIt;
+    };
+
+    struct StatementCache {
+        QHash<QString, StatementCacheEntry> statements;
+        // Least recently used statement is at the front. The entries keep their position, so a hit moves it without a search.
+        std::list<QString> usageOrder;
+        StatementCacheStats stats;
+
+        StatementCache() = default;
+        // The iterators of a copy must point into its own usage order, the manager is copyable.
+        StatementCache(const StatementCache &other);
+        StatementCache &operator=(const StatementCache &other);
+
+        void insert(const QString &key, const QSqlQuery &query);
+        void markUsed(StatementCacheEntry &entry);
+        void shrink(int capacity);
+        void clear();
+    };
+
+    struct SchemaCache {
+        // -1 means the cache is not loaded.
+        int schemaVersion = -1;
+        // Keys are the lower case table names. An empty column list means the columns are not loaded yet.
+        QHash<QString, QList<ColumnDefinition>> tables;
+    };
+
+    struct ResultCacheEntry {
+        QList<QMap<QString, QVariant>> rows;
+        // Lower case
+        QString tableName;
+        qint64 size = 0;
+    };
+
+    struct ResultCache {
+        QHash<QByteArray, ResultCacheEntry> entries;
+        // Least recently used entry is at the front.
+        QList<QByteArray> usageOrder;
+        // `PRAGMA data_version` when the entries were cached, it changes when another connection commits.
+        qint64 dataVersion = -1;
+        ResultCacheStats stats;
+
+        void remove(const QByteArray &key);
+        void removeTable(const QString &tableName);
+        void clear();
+    };
+
+    /**
+     * @brief Holds the state of a connection that is shared by all of the managers that use it. A connection is shared by name (e.g
+     * CacheManager and SettingsManager use the same connection for the same file), so a write through any of the managers has to be seen
+     * by the others. Released when the last manager drops the connection.
+     */
+    struct SharedConnectionState {
+        QString connectionName;
+        void *handle = nullptr;
+        ResultCache resultCache;
+        // The update hook is installed on the handle with the address of resultCache.
+        bool isUpdateHookInstalled = false;
+        // Restarted with every statement of the managers that track their activity.
+        QElapsedTimer activityTimer;
+        // Number of Transaction instances that are currently active on this connection, through any of the managers. It also names
+        // the savepoint of the next Transaction.
+        int transactionDepth = 0;
+        // Set when `PRAGMA data_version` is checked inside a transaction or a pass of the event loop, the result cache skips the check
+        // until the transaction ends or the event loop is about to block.
+        bool isDataVersionChecked = false;
+        QMetaObject::Connection eventLoopConnection;
+    };
+
+    struct SharedConnectionRegistry {
+        QMutex mutex;
+        // Connection name -> Shared state
+        QHash<QString, QWeakPointer<SharedConnectionState>> states;
+    };
+
+    /**
+     * @brief Holds the state that belongs to a single connection. When the underlying sqlite3 handle changes (e.g the database is
+     * closed and opened again) the state is reset.
+     */
+    struct ConnectionState {
+        void *handle = nullptr;
+        StatementCache statementCache;
+        SchemaCache schemaCache;
+        // -1 means it is not read yet.
+        int sqliteVersion = -1;
+        // Null If the connection is not open.
+        QSharedPointer<SharedConnectionState> shared;
+    };
+
+    struct QueryStatsEntry {
+        QueryStats stats;
+        // Ring buffer of the most recent execution times, used for the percentile.
+        QVector<qint64> samples;
+        int nextSampleIndex = 0;
+    };
+
     SqliteError m_LastError;
+    QHash<QString, ConnectionState> m_Connections;
+    int m_StatementCacheCapacity;
+    qint64 m_ResultCacheCapacity;
+    bool m_IsQueryStatsEnabled;
+    // Normalized query -> Statistics
+    QHash<QString, QueryStatsEntry> m_QueryStats;
+    // Query -> Normalized query
+    QHash<QString, QString> m_NormalizedQueries;
+    int m_SlowQueryThreshold;
+    SlowQueryCallback m_SlowQueryCallback;
+    bool m_IsActivityTracked;
 
 private:
     void updateError(QSqlDatabase &db, const QString &query = "");
+    void updateError(const QSqlQuery &query, const QString &sqlQueryStr);
+
+    /**
+     * @brief Returns the sqlite3 handle of the given connection as an opaque pointer, or nullptr If the connection is not open.
+     * @param database
+     * @return void *
+     */
+    static void *getHandle(const QSqlDatabase &database);
+    static void *getHandle(const QSqlDriver *driver);
+
+    /**
+     * @brief Returns the sqlite3_stmt handle of the given prepared query as an opaque pointer, or nullptr If it is not prepared.
+     * @param query
+     * @return void *
+     */
+    static void *getStatementHandle(const QSqlQuery &query);
+
+    /**
+     * @brief Restarts the activity timer of the connection that `query` belongs to.
+     * @param query
+     */
+    void markActivity(const QSqlQuery &query);
+    ConnectionState &getConnectionState(const QSqlDatabase &database);
+
+    /**
+     * @brief Prepares the given query or returns the already prepared one from the statement cache. The query is keyed with its
+     * trimmed text, so the same SQL shape always reuses the same statement. Only SELECT, INSERT, UPDATE, DELETE, REPLACE and WITH
+     * statements are cached. One-off statements like DDL, PRAGMA or VACUUM are prepared every time, so they do not evict the hot ones.
+     * @param database
+     * @param sqlQueryStr
+     * @param query
+     * @return bool Returns false If the statement cannot be prepared.
+     */
+    bool prepareQuery(QSqlDatabase &database, const QString &sqlQueryStr, QSqlQuery &query);
+
+    /**
+     * @brief Returns true If the statement is a DML statement that is worth keeping in the statement cache.
+     * @param sqlQueryStr
+     * @return bool
+     */
+    static bool isCacheableStatement(const QString &sqlQueryStr);
+
+    /**
+     * @brief Executes the prepared query and updates the last error If it fails.
+     * @param query
+     * @param sqlQueryStr
+     * @return bool
+     */
+    bool execQuery(QSqlQuery &query, const QString &sqlQueryStr);
+
+    /**
+     * @brief Reads a single CSV record from the device. A quoted field may span multiple lines.
+     * @param device
+     * @param delimiter
+     * @param fields
+     * @param bytesRead Incremented by the number of bytes read.
+     * @param readTimeout See ImportOptions::readTimeout.
+     * @return bool Returns false If there's nothing left to read.
+     */
+    static bool readCsvRecord(QIODevice *device, const QChar &delimiter, QStringList &fields, qint64 &bytesRead, int readTimeout);
+
+    /**
+     * @brief Reads a line including its newline. On a sequential device, an empty read only means that the data has not arrived yet,
+     * so it waits for the rest of the line.
+     * @param device
+     * @param readTimeout See ImportOptions::readTimeout.
+     * @return QByteArray Empty If there's nothing left to read.
+     */
+    static QByteArray readDeviceLine(QIODevice *device, int readTimeout);
+
+    /**
+     * @brief Quotes the CSV field If it contains the delimiter, a quote or a line break.
+     * @param field
+     * @param delimiter
+     * @return QString
+     */
+    static QString escapeCsvField(const QString &field, const QChar &delimiter);
+
+    /**
+     * @brief Replaces the string and number literals with ? and collapses the whitespace.
+     * @param sqlQueryStr
+     * @return QString
+     */
+    static QString normalizeQuery(const QString &sqlQueryStr);
+    QueryStatsEntry &getQueryStatsEntry(const QString &sqlQueryStr);
+
+    /**
+     * @brief Records a single execution of the statement.
+     * @param query
+     * @param sqlQueryStr
+     * @param elapsed In microseconds.
+     * @param successful
+     */
+    void recordExecution(const QSqlQuery &query, const QString &sqlQueryStr, qint64 elapsed, bool successful);
+
+    /**
+     * @brief Called by the Cursor when it is closed with the number of rows it has read and the time it spent on reading them.
+     * @param sqlQueryStr
+     * @param rowCount
+     * @param elapsed In microseconds.
+     */
+    void recordFetch(const QString &sqlQueryStr, qint64 rowCount, qint64 elapsed);
+
+    /**
+     * @brief Returns the cached rows for the key, If there are any. Drops the whole cache first If another connection has committed since
+     * the rows were cached.
+     * @param database
+     * @param key
+     * @param rows
+     * @return bool
+     */
+    bool readResultCache(QSqlDatabase &database, const QByteArray &key, QList<QMap<QString, QVariant>> &rows);
+    void writeResultCache(QSqlDatabase &database, const QByteArray &key, const QString &tableName, const QList<QMap<QString, QVariant>> &rows);
+
+    /**
+     * @brief Returns the shared state of the connection, creates it If no other manager is using the connection.
+     * @param connectionName
+     * @param handle
+     * @return QSharedPointer<SharedConnectionState>
+     */
+    static QSharedPointer<SharedConnectionState> acquireSharedState(const QString &connectionName, void *handle);
+
+    /**
+     * @brief Deleter of the shared state. Removes the update hook If the connection is still open with the same handle.
+     * @param state
+     */
+    static void releaseSharedState(SharedConnectionState *state);
+    static SharedConnectionRegistry &getSharedConnectionRegistry();
+
+    /**
+     * @brief Update hook of the connections that have a result cache. `context` is the ResultCache of the connection. Only installed
+     * when QUTILS_SQLITE_NATIVE is defined.
+     */
+    static void onRowChanged(void *context, int operation, const char *databaseName, const char *tableName, long long rowID);
+
+    /**
+     * @brief Called by the write helpers after they change a table.
+     * @param database
+     * @param tableName
+     */
+    void onTableWritten(const QSqlDatabase &database, const QString &tableName);
+
+    /**
+     * @brief Returns the SELECT query used by getFromTable().
+     * @param tableName
+     * @param columns If it is empty, all of the columns are selected.
+     * @param limit
+     * @param where
+     * @param selectOrder
+     * @param values The values to bind are written here.
+     * @return QString
+     */
+    QString constructSelectQuery(const QString &tableName, const QStringList &columns, const unsigned int &limit, const Where &where,
+                                 const SelectOrder *selectOrder, QVariantList &values) const;
+
+    /**
+     * @brief Converts the legacy constraints to a Where so that their values are bound instead of spliced into the query.
+     * @param constraints
+     * @return Where
+     */
+    Where toWhere(const QList<Constraint> &constraints) const;
+
+    /**
+     * @brief Binds the values to the positional placeholders starting from `startIndex`.
+     * @param query
+     * @param values
+     * @param startIndex
+     */
+    void bindQueryValues(QSqlQuery &query, const QVariantList &values, int startIndex = 0) const;
+
+    /**
+     * @brief Returns an INSERT query with positional placeholders for the given columns.
+     * @param tableName
+     * @param columnNames
+     * @return QString
+     */
+    QString constructInsertQuery(const QString &tableName, const QStringList &columnNames) const;
+
+    /**
+     * @brief Executes the given PRAGMA and returns the first column of the first row.
+     * @param database
+     * @param pragma For example "journal_mode=WAL"
+     * @param ok Set to false If the PRAGMA fails.
+     * @return QVariant
+     */
+    QVariant executePragma(QSqlDatabase &database, const QString &pragma, bool *ok = nullptr);
+
+    /**
+     * @brief Reads `PRAGMA schema_version` of the given connection. It is not recorded in the query stats.
+     * @param database
+     * @return int Returns -1 If there's an error.
+     */
+    int readSchemaVersion(QSqlDatabase &database);
+
+    /**
+     * @brief Reloads the table names If the schema version of the database is different from the cached one.
+     * @param database
+     * @return bool Returns false If the schema cannot be read.
+     */
+    bool refreshSchemaCache(QSqlDatabase &database);
+
+    /**
+     * @brief Checks the table in the schema cache. A cached table is returned without touching the database. On a miss, `PRAGMA
+     * schema_version` is read and the table list is reloaded If it changed, so a table created by another connection is found.
+     * @param database
+     * @param tableName
+     * @return bool
+     */
+    bool hasTable(QSqlDatabase &database, const QString &tableName);
+
+    /**
+     * @brief Applies a schema change that was made through this connection to the cache. If someone else has also changed the schema
+     * in the meantime, the cache is invalidated instead.
+     * @param database
+     * @param tableName
+     * @param columns Ignored If isDropped is true.
+     * @param isDropped
+     */
+    void updateSchemaCache(QSqlDatabase &database, const QString &tableName, const QList<ColumnDefinition> &columns, bool isDropped);
 
 };
 
@@ -0,0 +1,170 @@
+#pragma once
+// Qt
+#include <QMap>
+// qutils
+#include "qutils/SqliteManager.h"
+
+namespace zmc
+{
+
+/**
+ * @brief The SqliteMigrator class brings a database schema up to date with an ordered list of migrations. The version of the database is
+ * kept in `PRAGMA user_version`. All of the pending migrations are applied in a single transaction, so either the database is migrated to
+ * the latest version or it is left as it was.
+ *
+ * A migration is a list of SQL statements or a function. Prefer the statements that change the data in place (ALTER TABLE,
+ * INSERT ... SELECT, UPDATE) to reading the rows into C++ and writing them back. The helpers in this class create such statements.
+ * Note that `PRAGMA foreign_keys` cannot be changed inside a transaction, so turn it off before migrate() If a table that is referenced
+ * by a foreign key is rebuilt.
+ * **Example Usage:**
+ * @code
+ *    SqliteManager man;
+ *    SqliteMigrator migrator(man);
+ *    migrator.addMigration(1, "Create the logs table", {"CREATE TABLE logs (message TEXT NOT NULL)"});
+ *    migrator.addMigration(2, "Add the level column", {
+ *        migrator.addColumn("logs", SqliteManager::ColumnDefinition(true, SqliteManager::ColumnTypes::INTEGER, "level"))
+ *    });
+ *    migrator.addMigration(3, "Make the level required", migrator.rebuildTable("logs", {
+ *        SqliteManager::ColumnDefinition(false, SqliteManager::ColumnTypes::TEXT, "message"),
+ *        SqliteManager::ColumnDefinition(false, SqliteManager::ColumnTypes::INTEGER, "level")
+ *    }, {{"level", "IFNULL(level, 0)"}}));
+ *
+ *    const SqliteMigrator::Result result = migrator.migrate(db);
+ *    for (const SqliteMigrator::StepResult &step : result.steps) {
+ *        qDebug() << step.version << step.description << step.elapsed;
+ *    }
+ * @endcode
+ */
+class SqliteMigrator
+{
+public:
+    using MigrationFunction = std::function<bool(SqliteManager &manager, QSqlDatabase &database)>;
+
+    struct StepResult {
+        StepResult() = default;
+
+        int version = 0;
+        QString description;
+        bool isSuccessful = false;
+        // In milliseconds
+        qint64 elapsed = 0;
+        QSqlError error;
+    };
+
+    struct Result {
+        Result() = default;
+
+        int fromVersion = -1;
+        int toVersion = -1;
+        bool isSuccessful = false;
+        // In milliseconds
+        qint64 elapsed = 0;
+        // The steps that were run. If a step failed, it is the last one.
+        QList<StepResult> steps;
+    };
+
+public:
+    explicit SqliteMigrator(SqliteManager &manager);
+
+    /**
+     * @brief Adds a migration that runs the given statements in order. Versions must be greater than 0 and unique, a migration with the
+     * same version replaces the existing one.
+     * @param version
+     * @param description
+     * @param statements
+     * @return SqliteMigrator &
+     */
+    SqliteMigrator &addMigration(int version, const QString &description, const QStringList &statements);
+
+    /**
+     * @brief Adds a migration that runs the given function. The function is already inside the migration transaction, return false to
+     * roll back the whole migration.
+     * @param version
+     * @param description
+     * @param function
+     * @return SqliteMigrator &
+     */
+    SqliteMigrator &addMigration(int version, const QString &description, const MigrationFunction &function);
+
+    /**
+     * @brief Returns the `PRAGMA user_version` of the database, or -1 If it cannot be read.
+     * @param database
+     * @return int
+     */
+    int getCurrentVersion(QSqlDatabase &database) const;
+
+    /**
+     * @brief Returns the version of the last migration, or 0 If there are no migrations.
+     * @return int
+     */
+    int getLatestVersion() const;
+
+    /**
+     * @brief Applies the migrations whose versions are greater than the current version and not greater than `targetVersion`. If the
+     * target version is negative, the database is migrated to the latest version. Migrating to an older version is not supported.
+     * @param database
+     * @param targetVersion
+     * @return Result
+     */
+    Result migrate(QSqlDatabase &database, int targetVersion = -1);
+
+    /**
+     * @brief Returns an `ALTER TABLE ... ADD COLUMN` statement. A NOT NULL column needs a default value.
+     * @param tableName
+     * @param column
+     * @param defaultValue An SQL expression, e.g `0` or `'unknown'`. Ignored If it is empty.
+     * @return QString
+     */
+    QString addColumn(const QString &tableName, const SqliteManager::ColumnDefinition &column, const QString &defaultValue = QString()) const;
+
+    QString renameTable(const QString &tableName, const QString &newTableName) const;
+
+    /**
+     * @brief Returns an `ALTER TABLE ... RENAME COLUMN` statement. Requires SQLite 3.25.
+     * @param tableName
+     * @param columnName
+     * @param newColumnName
+     * @return QString
+     */
+    QString renameColumn(const QString &tableName, const QString &columnName, const QString &newColumnName) const;
+
+    /**
+     * @brief Returns an `INSERT INTO ... SELECT` statement that copies the rows of `sourceTableName` into `targetTableName` without
+     * reading them into memory.
+     * @param sourceTableName
+     * @param targetTableName
+     * @param columnExpressions Target column -> SQL expression over the source columns. A column with an empty expression is copied
+     * from the source column with the same name.
+     * @return QString
+     */
+    QString copyRows(const QString &sourceTableName, const QString &targetTableName, const QMap<QString, QString> &columnExpressions) const;
+
+    /**
+     * @brief Returns the statements that recreate the table with the new columns, for the changes ALTER TABLE cannot do (e.g changing
+     * the type of a column or dropping a column). The rows are copied with INSERT ... SELECT and the old table is dropped. Indexes and
+     * triggers of the old table are dropped with it, so create them again in the same migration.
+     * @param tableName
+     * @param columns The new columns.
+     * @param columnExpressions New column -> SQL expression over the old columns. The columns that are not in the map are copied from
+     * the old column with the same name.
+     * @return QStringList
+     */
+    QStringList rebuildTable(const QString &tableName, const QList<SqliteManager::ColumnDefinition> &columns,
+                             const QMap<QString, QString> &columnExpressions = QMap<QString, QString>()) const;
+
+private:
+    struct Migration {
+        QString description;
+        QStringList statements;
+        MigrationFunction function;
+    };
+
+    SqliteManager &m_Manager;
+    // Version -> Migration
+    QMap<int, Migration> m_Migrations;
+
+private:
+    QString getColumnDefinitionText(const SqliteManager::ColumnDefinition &column) const;
+};
+
+}
@@ -0,0 +1,183 @@
+#pragma once
+// Qt
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include <QMap>
+
+class QSqlQuery;
+
+namespace zmc
+{
+
+/**
+ * @brief The SqliteResultSet class stores the results of a query column by column. The column names are stored once and the values of
+ * each column are kept in a contiguous vector. INTEGER, REAL, TEXT and BLOB columns are stored in typed vectors, so reading them does
+ * not go through a QVariant. If a column contains values of different types (sqlite allows this), that column falls back to storing
+ * QVariants.
+ * **Example Usage:**
+ * @code
+ *    SqliteManager man;
+ *    SqliteResultSet resultSet;
+ *    man.getFromTable(db, "my_table", resultSet);
+ *    const int firstColumn = resultSet.getColumnIndex("first");
+ *    for (const SqliteResultSet::RowView &row : resultSet) {
+ *        qDebug() << row.toInteger(firstColumn);
+ *    }
+ * @endcode
+ */
+class SqliteResultSet
+{
+public:
+    enum class StorageType {
+        NONE, // All of the values so far are NULL
+        INTEGER,
+        REAL,
+        TEXT,
+        BLOB,
+        VARIANT
+    };
+
+    /**
+     * @brief Cheap view to a row of a result set. It is only valid as long as the result set is alive.
+     */
+    class RowView
+    {
+    public:
+        RowView(const SqliteResultSet *resultSet, int rowIndex);
+
+        int getRowIndex() const;
+
+        bool isNull(int columnIndex) const;
+        QVariant value(int columnIndex) const;
+        QVariant value(const QString &columnName) const;
+
+        qint64 toInteger(int columnIndex) const;
+        double toReal(int columnIndex) const;
+        QString toText(int columnIndex) const;
+        QByteArray toBlob(int columnIndex) const;
+
+        QMap<QString, QVariant> toMap() const;
+
+    private:
+        const SqliteResultSet *m_ResultSet;
+        int m_RowIndex;
+    };
+
+    class const_iterator
+    {
+    public:
+        const_iterator(const SqliteResultSet *resultSet, int rowIndex)
+            : m_ResultSet(resultSet)
+            , m_RowIndex(rowIndex)
+        {}
+
+        RowView operator*() const
+        {
+            return RowView(m_ResultSet, m_RowIndex);
+        }
+
+        const_iterator &operator++()
+        {
+            m_RowIndex++;
+            return *this;
+        }
+
+        bool operator!=(const const_iterator &other) const
+        {
+            return m_RowIndex != other.m_RowIndex || m_ResultSet != other.m_ResultSet;
+        }
+
+    private:
+        const SqliteResultSet *m_ResultSet;
+        int m_RowIndex;
+    };
+
+public:
+    SqliteResultSet();
+    explicit SqliteResultSet(const QStringList &columnNames);
+
+    /**
+     * @brief Removes all of the rows and the columns.
+     */
+    void clear();
+
+    /**
+     * @brief Removes the rows and sets the columns to the given names.
+     * @param columnNames
+     */
+    void setColumnNames(const QStringList &columnNames);
+    QStringList getColumnNames() const;
+
+    /**
+     * @brief Returns the index of the column with the given name, or -1 If there's no such column.
+     * @param columnName
+     * @return int
+     */
+    int getColumnIndex(const QString &columnName) const;
+    int getColumnCount() const;
+    int getRowCount() const;
+    bool isEmpty() const;
+
+    StorageType getStorageType(int columnIndex) const;
+
+    /**
+     * @brief Reserves memory for the given number of rows in every column.
+     * @param rowCount
+     */
+    void reserve(int rowCount);
+
+    /**
+     * @brief Appends the current row of the given query. The query must have the same columns as this result set.
+     * @param query
+     */
+    void appendRow(const QSqlQuery &query);
+
+    /**
+     * @brief Appends a row. The values must be in the same order as the columns.
+     * @param values
+     */
+    void appendRow(const QVariantList &values);
+
+    RowView at(int rowIndex) const;
+    RowView operator[](int rowIndex) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * @brief Converts the result set to the row based format returned by SqliteManager::executeSelectQuery().
+     * @return QList<QMap<QString, QVariant>>
+     */
+    QList<QMap<QString, QVariant>> toList() const;
+
+private:
+    struct Column {
+        StorageType type = StorageType::NONE;
+        // Only the vector that matches the type is used.
+        QVector<qint64> integers;
+        QVector<double> reals;
+        QVector<QString> texts;
+        QVector<QByteArray> blobs;
+        QVector<QVariant> variants;
+        QVector<bool> nulls;
+    };
+
+    QStringList m_ColumnNames;
+    QVector<Column> m_Columns;
+    int m_RowCount;
+
+private:
+    void appendValue(Column &column, const QVariant &value);
+
+    /**
+     * @brief Moves the values of the column to the variants vector. This is used when a column contains values of different types.
+     * @param column
+     */
+    void convertToVariant(Column &column) const;
+
+    QVariant getValue(int columnIndex, int rowIndex) const;
+    static StorageType getValueStorageType(const QVariant &value);
+};
+
+}
@@ -0,0 +1,606 @@
+#pragma once
+// Qt
+#include <QByteArray>
+// qutils
+#include "qutils/SqliteManager.h"
+#include "qutils/Macros.h"
+#ifdef QUTILS_SQLITE_NATIVE
+// sqlite
+#include <sqlite3.h>
+#endif // QUTILS_SQLITE_NATIVE
+// std
+#include <vector>
+#include <type_traits>
+
+namespace zmc
+{
+
+/**
+ * @brief Returns the column type that is used for a field of type T when the field does not specify one.
+ */
+template<typename T, typename Enable = void>
+struct SqliteColumnType {
+    static SqliteManager::ColumnTypes get()
+    {
+        return SqliteManager::ColumnTypes::TEXT;
+    }
+};
+
+template<typename T>
+struct SqliteColumnType<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+    static SqliteManager::ColumnTypes get()
+    {
+        return SqliteManager::ColumnTypes::INTEGER;
+    }
+};
+
+template<typename T>
+struct SqliteColumnType<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static SqliteManager::ColumnTypes get()
+    {
+        return SqliteManager::ColumnTypes::REAL;
+    }
+};
+
+template<>
+struct SqliteColumnType<QByteArray> {
+    static SqliteManager::ColumnTypes get()
+    {
+        return SqliteManager::ColumnTypes::BLOB;
+    }
+};
+
+#ifdef QUTILS_SQLITE_NATIVE
+/**
+ * @brief Binds and reads a field of type T with the sqlite3 API, so the value is not boxed in a QVariant. The types without a
+ * specialization go through QVariant, the same way Qt's driver binds and reads them. The indexes are 0 based.
+ */
+template<typename T, typename Enable = void>
+struct SqliteNativeValue;
+
+template<>
+struct SqliteNativeValue<QVariant> {
+    static int bind(sqlite3_stmt *statement, int index, const QVariant &value)
+    {
+        if (value.isNull()) {
+            return sqlite3_bind_null(statement, index + 1);
+        }
+
+        switch (value.type()) {
+        case QVariant::Bool:
+        case QVariant::Int:
+        case QVariant::UInt:
+        case QVariant::LongLong:
+        case QVariant::ULongLong:
+            return sqlite3_bind_int64(statement, index + 1, value.toLongLong());
+        case QVariant::Double:
+            return sqlite3_bind_double(statement, index + 1, value.toDouble());
+        case QVariant::ByteArray: {
+            const QByteArray data = value.toByteArray();
+            return sqlite3_bind_blob(statement, index + 1, data.constData(), data.size(), SQLITE_TRANSIENT);
+        }
+        default: {
+            const QString text = value.toString();
+            return sqlite3_bind_text16(statement, index + 1, text.utf16(), text.size() * static_cast<int>(sizeof(QChar)), SQLITE_TRANSIENT);
+        }
+        }
+    }
+
+    static QVariant read(sqlite3_stmt *statement, int index)
+    {
+        switch (sqlite3_column_type(statement, index)) {
+        case SQLITE_INTEGER:
+            return static_cast<qint64>(sqlite3_column_int64(statement, index));
+        case SQLITE_FLOAT:
+            return sqlite3_column_double(statement, index);
+        case SQLITE_BLOB:
+            return QByteArray(static_cast<const char *>(sqlite3_column_blob(statement, index)), sqlite3_column_bytes(statement, index));
+        case SQLITE_TEXT:
+            return QString(static_cast<const QChar *>(sqlite3_column_text16(statement, index)),
+                           sqlite3_column_bytes16(statement, index) / static_cast<int>(sizeof(QChar)));
+        default:
+            return QVariant();
+        }
+    }
+};
+
+template<typename T, typename Enable>
+struct SqliteNativeValue {
+    static int bind(sqlite3_stmt *statement, int index, const T &value)
+    {
+        return SqliteNativeValue<QVariant>::bind(statement, index, QVariant::fromValue(value));
+    }
+
+    static T read(sqlite3_stmt *statement, int index)
+    {
+        return qvariant_cast<T>(SqliteNativeValue<QVariant>::read(statement, index));
+    }
+};
+
+template<typename T>
+struct SqliteNativeValue<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+    static int bind(sqlite3_stmt *statement, int index, const T &value)
+    {
+        return sqlite3_bind_int64(statement, index + 1, static_cast<sqlite3_int64>(value));
+    }
+
+    static T read(sqlite3_stmt *statement, int index)
+    {
+        return static_cast<T>(sqlite3_column_int64(statement, index));
+    }
+};
+
+template<typename T>
+struct SqliteNativeValue<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static int bind(sqlite3_stmt *statement, int index, const T &value)
+    {
+        return sqlite3_bind_double(statement, index + 1, static_cast<double>(value));
+    }
+
+    static T read(sqlite3_stmt *statement, int index)
+    {
+        return static_cast<T>(sqlite3_column_double(statement, index));
+    }
+};
+
+template<>
+struct SqliteNativeValue<QString> {
+    static int bind(sqlite3_stmt *statement, int index, const QString &value)
+    {
+        if (value.isNull()) {
+            return sqlite3_bind_null(statement, index + 1);
+        }
+
+        return sqlite3_bind_text16(statement, index + 1, value.utf16(), value.size() * static_cast<int>(sizeof(QChar)), SQLITE_TRANSIENT);
+    }
+
+    static QString read(sqlite3_stmt *statement, int index)
+    {
+        const void *text = sqlite3_column_text16(statement, index);
+        if (text == nullptr) {
+            return QString();
+        }
+
+        return QString(static_cast<const QChar *>(text), sqlite3_column_bytes16(statement, index) / static_cast<int>(sizeof(QChar)));
+    }
+};
+
+template<>
+struct SqliteNativeValue<QByteArray> {
+    static int bind(sqlite3_stmt *statement, int index, const QByteArray &value)
+    {
+        if (value.isNull()) {
+            return sqlite3_bind_null(statement, index + 1);
+        }
+
+        return sqlite3_bind_blob(statement, index + 1, value.constData(), value.size(), SQLITE_TRANSIENT);
+    }
+
+    static QByteArray read(sqlite3_stmt *statement, int index)
+    {
+        const void *data = sqlite3_column_blob(statement, index);
+        if (data == nullptr) {
+            return QByteArray();
+        }
+
+        return QByteArray(static_cast<const char *>(data), sqlite3_column_bytes(statement, index));
+    }
+};
+#endif // QUTILS_SQLITE_NATIVE
+
+/**
+ * @brief The SqliteTypedTable class maps the rows of a table to a C++ struct. The struct declares its fields once with a static
+ * `visitSqliteFields()` function that passes a member pointer for every column. The CREATE, INSERT and SELECT queries are generated
+ * from the fields once when the table is constructed, and the columns are read by index straight into the members. The rows are
+ * returned in a std::vector, there are no intermediate QMaps.
+ *
+ * Any type that QVariant can hold can be used as a field. Integral types are stored as INTEGER, floating point types as REAL,
+ * QByteArray as BLOB and everything else as TEXT, unless the field gives a column type. The columns are nullable unless the field says
+ * otherwise. INTEGER PRIMARY KEY columns are left out of the INSERT, so SQLite assigns them.
+ *
+ * The INSERT and SELECT statements are prepared once through the statement cache of the manager. With QUTILS_SQLITE_NATIVE, the fields
+ * are bound and read with the sqlite3 API and the rows are stepped directly, so the integral, floating point, QString and QByteArray
+ * fields are never boxed in a QVariant. These statements are not recorded in the query stats in that case.
+ * **Example Usage:**
+ * @code
+ *    struct LogEntry {
+ *        qint64 id = 0;
+ *        QString message;
+ *        int level = 0;
+ *
+ *        template<typename Visitor>
+ *        static void visitSqliteFields(Visitor &visitor)
+ *        {
+ *            visitor.field("id", &LogEntry::id, SqliteManager::ColumnTypes::PK_AUTOINCREMENT);
+ *            visitor.field("message", &LogEntry::message, SqliteManager::ColumnTypes::TEXT, false);
+ *            visitor.field("level", &LogEntry::level);
+ *        }
+ *    };
+ *
+ *    SqliteTypedTable<LogEntry> logs(man, "logs");
+ *    logs.createTable(db);
+ *    logs.insert(db, entry);
+ *    const std::vector<LogEntry> errors = logs.select(db, SqliteManager::Where().where("level", SqliteWhere::Operator::GREATER, 2));
+ * @endcode
+ */
+template<typename T>
+class SqliteTypedTable
+{
+public:
+    SqliteTypedTable(SqliteManager &manager, const QString &tableName)
+        : m_Manager(manager)
+        , m_TableName(tableName)
+        , m_Columns()
+        , m_CreateQuery()
+        , m_InsertQuery()
+        , m_SelectQuery()
+    {
+        ColumnCollector collector(m_Columns);
+        T::visitSqliteFields(collector);
+
+        QStringList columnDefinitions, insertColumns, placeholders, selectColumns;
+        for (const SqliteManager::ColumnDefinition &column : m_Columns) {
+            const QString quotedName = SqliteWhere::quoteIdentifier(column.name);
+            columnDefinitions.append((quotedName + " " + m_Manager.getColumnTypeName(column.type) + " " + column.getNullText()).trimmed());
+            selectColumns.append(quotedName);
+            if (isPrimaryKey(column) == false) {
+                insertColumns.append(quotedName);
+                placeholders.append("?");
+            }
+        }
+
+        const QString quotedTableName = SqliteWhere::quoteIdentifier(m_TableName);
+        m_CreateQuery = "CREATE TABLE IF NOT EXISTS " + quotedTableName + " (" + columnDefinitions.join(',') + ")";
+        m_InsertQuery = "INSERT INTO " + quotedTableName + " (" + insertColumns.join(',') + ") VALUES(" + placeholders.join(',') + ")";
+        m_SelectQuery = "SELECT " + selectColumns.join(',') + " FROM " + quotedTableName;
+    }
+
+    QString getTableName() const
+    {
+        return m_TableName;
+    }
+
+    QList<SqliteManager::ColumnDefinition> getColumns() const
+    {
+        return m_Columns;
+    }
+
+    QString getCreateQuery() const
+    {
+        return m_CreateQuery;
+    }
+
+    QString getInsertQuery() const
+    {
+        return m_InsertQuery;
+    }
+
+    QString getSelectQuery() const
+    {
+        return m_SelectQuery;
+    }
+
+    /**
+     * @brief Creates the table If it does not exist.
+     * @param database
+     * @return bool
+     */
+    bool createTable(QSqlDatabase &database)
+    {
+        return m_Manager.executeQuery(database, m_CreateQuery);
+    }
+
+    bool insert(QSqlDatabase &database, const T &row)
+    {
+        QSqlQuery query;
+        if (m_Manager.prepareQuery(database, m_InsertQuery, query) == false) {
+            return false;
+        }
+
+        const bool successful = insertRow(query, row);
+        query.finish();
+        if (successful) {
+            m_Manager.onTableWritten(database, m_TableName);
+        }
+
+        return successful;
+    }
+
+    /**
+     * @brief Inserts all of the rows in a single transaction. The statement is prepared once and every row is bound to it. A failing
+     * row does not abort the batch.
+     * @param database
+     * @param rows
+     * @return SqliteManager::BatchResult
+     */
+    SqliteManager::BatchResult insert(QSqlDatabase &database, const std::vector<T> &rows)
+    {
+        SqliteManager::BatchResult result;
+        SqliteManager::Transaction transaction(m_Manager, database);
+        if (transaction.isActive() == false) {
+            return result;
+        }
+
+        QSqlQuery query;
+        if (m_Manager.prepareQuery(database, m_InsertQuery, query) == false) {
+            return result;
+        }
+
+        for (int rowIndex = 0; rowIndex < static_cast<int>(rows.size()); rowIndex++) {
+            if (insertRow(query, rows[rowIndex])) {
+                result.insertedCount++;
+            }
+            else {
+                result.failedRows.insert(rowIndex, m_Manager.getLastError().error);
+            }
+        }
+
+        query.finish();
+        if (result.insertedCount > 0) {
+            m_Manager.onTableWritten(database, m_TableName);
+        }
+
+        result.isCommitted = transaction.commit();
+        if (result.isCommitted == false) {
+            result.insertedCount = 0;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Returns the rows that match `where`.
+     * @param database
+     * @param where
+     * @param limit
+     * @param selectOrder If it is nullptr, the order is not specified.
+     * @return std::vector<T>
+     */
+    std::vector<T> select(QSqlDatabase &database, const SqliteWhere &where = SqliteWhere(), const unsigned int &limit = -1,
+                          const SqliteManager::SelectOrder *selectOrder = nullptr)
+    {
+        QString sqlQueryStr = m_SelectQuery;
+        QVariantList bindValues = where.getBindValues();
+        if (where.isEmpty() == false) {
+            sqlQueryStr += " " + where.getQuery();
+        }
+
+        if (selectOrder && selectOrder->fieldName.length() > 0) {
+            sqlQueryStr += " ORDER BY " + selectOrder->fieldName +
+                           (selectOrder->order == SqliteManager::SelectOrder::OrderType::ASC ? " ASC" : " DESC");
+        }
+
+        if (limit > 0) {
+            sqlQueryStr += " LIMIT ?";
+            bindValues.append(limit);
+        }
+
+        std::vector<T> rows;
+#ifdef QUTILS_SQLITE_NATIVE
+        QSqlQuery query;
+        if (m_Manager.prepareQuery(database, sqlQueryStr, query) == false) {
+            return rows;
+        }
+
+        sqlite3_stmt *statement = static_cast<sqlite3_stmt *>(SqliteManager::getStatementHandle(query));
+        if (statement) {
+            sqlite3_reset(statement);
+            sqlite3_clear_bindings(statement);
+            for (int index = 0; index < bindValues.size(); index++) {
+                SqliteNativeValue<QVariant>::bind(statement, index, bindValues.at(index));
+            }
+
+            int resultCode = sqlite3_step(statement);
+            while (resultCode == SQLITE_ROW) {
+                rows.emplace_back();
+                NativeRowReader reader(rows.back(), statement);
+                T::visitSqliteFields(reader);
+                resultCode = sqlite3_step(statement);
+            }
+
+            if (resultCode != SQLITE_DONE) {
+                updateNativeError(statement, resultCode, sqlQueryStr);
+            }
+
+            sqlite3_reset(statement);
+            m_Manager.markActivity(query);
+            return rows;
+        }
+#endif // QUTILS_SQLITE_NATIVE
+
+        SqliteManager::Cursor cursor = m_Manager.openCursor(database, sqlQueryStr, bindValues);
+        while (cursor.next()) {
+            rows.emplace_back();
+            RowReader reader(rows.back(), cursor);
+            T::visitSqliteFields(reader);
+        }
+
+        return rows;
+    }
+
+private:
+    class ColumnCollector
+    {
+    public:
+        explicit ColumnCollector(QList<SqliteManager::ColumnDefinition> &columns)
+            : m_Columns(columns)
+        {
+        }
+
+        template<typename U>
+        void field(const char *name, U T::*member, SqliteManager::ColumnTypes type = SqliteColumnType<U>::get(), bool isNullable = true)
+        {
+            Q_UNUSED(member);
+            m_Columns.append(SqliteManager::ColumnDefinition(isNullable, type, QString::fromUtf8(name)));
+        }
+
+    private:
+        QList<SqliteManager::ColumnDefinition> &m_Columns;
+    };
+
+    class ValueBinder
+    {
+    public:
+        ValueBinder(const T &row, QVariantList &values)
+            : m_Row(row)
+            , m_Values(values)
+        {
+        }
+
+        template<typename U>
+        void field(const char *name, U T::*member, SqliteManager::ColumnTypes type = SqliteColumnType<U>::get(), bool isNullable = true)
+        {
+            Q_UNUSED(name);
+            Q_UNUSED(isNullable);
+            if (type != SqliteManager::ColumnTypes::PK_INTEGER && type != SqliteManager::ColumnTypes::PK_AUTOINCREMENT) {
+                m_Values.append(QVariant::fromValue(m_Row.*member));
+            }
+        }
+
+    private:
+        const T &m_Row;
+        QVariantList &m_Values;
+    };
+
+    class RowReader
+    {
+    public:
+        RowReader(T &row, const SqliteManager::Cursor &cursor)
+            : m_Row(row)
+            , m_Cursor(cursor)
+            , m_ColumnIndex(0)
+        {
+        }
+
+        template<typename U>
+        void field(const char *name, U T::*member, SqliteManager::ColumnTypes type = SqliteColumnType<U>::get(), bool isNullable = true)
+        {
+            Q_UNUSED(name);
+            Q_UNUSED(type);
+            Q_UNUSED(isNullable);
+            m_Row.*member = qvariant_cast<U>(m_Cursor.value(m_ColumnIndex++));
+        }
+
+    private:
+        T &m_Row;
+        const SqliteManager::Cursor &m_Cursor;
+        int m_ColumnIndex;
+    };
+
+#ifdef QUTILS_SQLITE_NATIVE
+    class NativeValueBinder
+    {
+    public:
+        NativeValueBinder(const T &row, sqlite3_stmt *statement)
+            : m_Row(row)
+            , m_Statement(statement)
+            , m_ValueIndex(0)
+        {
+        }
+
+        template<typename U>
+        void field(const char *name, U T::*member, SqliteManager::ColumnTypes type = SqliteColumnType<U>::get(), bool isNullable = true)
+        {
+            Q_UNUSED(name);
+            Q_UNUSED(isNullable);
+            if (type != SqliteManager::ColumnTypes::PK_INTEGER && type != SqliteManager::ColumnTypes::PK_AUTOINCREMENT) {
+                SqliteNativeValue<U>::bind(m_Statement, m_ValueIndex++, m_Row.*member);
+            }
+        }
+
+    private:
+        const T &m_Row;
+        sqlite3_stmt *m_Statement;
+        int m_ValueIndex;
+    };
+
+    class NativeRowReader
+    {
+    public:
+        NativeRowReader(T &row, sqlite3_stmt *statement)
+            : m_Row(row)
+            , m_Statement(statement)
+            , m_ColumnIndex(0)
+        {
+        }
+
+        template<typename U>
+        void field(const char *name, U T::*member, SqliteManager::ColumnTypes type = SqliteColumnType<U>::get(), bool isNullable = true)
+        {
+            Q_UNUSED(name);
+            Q_UNUSED(type);
+            Q_UNUSED(isNullable);
+            m_Row.*member = SqliteNativeValue<U>::read(m_Statement, m_ColumnIndex++);
+        }
+
+    private:
+        T &m_Row;
+        sqlite3_stmt *m_Statement;
+        int m_ColumnIndex;
+    };
+#endif // QUTILS_SQLITE_NATIVE
+
+private:
+    SqliteManager &m_Manager;
+    const QString m_TableName;
+    QList<SqliteManager::ColumnDefinition> m_Columns;
+    QString m_CreateQuery, m_InsertQuery, m_SelectQuery;
+
+private:
+    static bool isPrimaryKey(const SqliteManager::ColumnDefinition &column)
+    {
+        return column.type == SqliteManager::ColumnTypes::PK_INTEGER || column.type == SqliteManager::ColumnTypes::PK_AUTOINCREMENT;
+    }
+
+    /**
+     * @brief Binds the row to the prepared INSERT statement and executes it.
+     * @param query
+     * @param row
+     * @return bool
+     */
+    bool insertRow(QSqlQuery &query, const T &row)
+    {
+#ifdef QUTILS_SQLITE_NATIVE
+        sqlite3_stmt *statement = static_cast<sqlite3_stmt *>(SqliteManager::getStatementHandle(query));
+        if (statement) {
+            sqlite3_reset(statement);
+            sqlite3_clear_bindings(statement);
+            NativeValueBinder binder(row, statement);
+            T::visitSqliteFields(binder);
+            const int resultCode = sqlite3_step(statement);
+            // The message is read before the reset.
+            if (resultCode != SQLITE_DONE) {
+                updateNativeError(statement, resultCode, m_InsertQuery);
+            }
+
+            sqlite3_reset(statement);
+            m_Manager.markActivity(query);
+            return resultCode == SQLITE_DONE;
+        }
+#endif // QUTILS_SQLITE_NATIVE
+
+        m_Manager.bindQueryValues(query, getBindValues(row));
+        return m_Manager.execQuery(query, m_InsertQuery);
+    }
+
+#ifdef QUTILS_SQLITE_NATIVE
+    void updateNativeError(sqlite3_stmt *statement, int resultCode, const QString &sqlQueryStr)
+    {
+        const QString message = QString::fromUtf8(sqlite3_errmsg(sqlite3_db_handle(statement)));
+        m_Manager.m_LastError.error = QSqlError(QString(), message, QSqlError::StatementError, QString::number(resultCode));
+        m_Manager.m_LastError.query = sqlQueryStr;
+        LOG_ERROR("Error occurred. Message: " << message << ". Query: " << sqlQueryStr);
+    }
+#endif // QUTILS_SQLITE_NATIVE
+
+    QVariantList getBindValues(const T &row) const
+    {
+        QVariantList values;
+        values.reserve(m_Columns.size());
+        ValueBinder binder(row, values);
+        T::visitSqliteFields(binder);
+        return values;
+    }
+};
+
+}
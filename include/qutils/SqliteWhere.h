@@ -0,0 +1,117 @@
+#pragma once
+// Qt
+#include <QString>
+#include <QVariantList>
+
+namespace zmc
+{
+
+/**
+ * @brief The SqliteWhere class builds the WHERE clause of a query with positional placeholders. The values are never spliced into the
+ * query, they are bound when the query is executed. So the same filter with different values always produces the same SQL and the
+ * prepared statement can be reused. Column names are quoted.
+ *
+ * Conditions are joined in the order they are added. Keep in mind that AND has a higher precedence than OR, use andGroup() and
+ * orGroup() to group conditions explicitly.
+ * **Example Usage:**
+ * @code
+ *    SqliteWhere nameFilter;
+ *    nameFilter.where("name", SqliteWhere::Operator::LIKE, "Furkan%")
+ *              .orWhere("name", SqliteWhere::Operator::IS_NULL);
+ *
+ *    SqliteWhere where;
+ *    where.where("age", SqliteWhere::Operator::BETWEEN, QVariantList{18, 30})
+ *         .andWhere("city", SqliteWhere::Operator::IN, QVariantList{"Istanbul", "Izmir"})
+ *         .andGroup(nameFilter);
+ *
+ *    qDebug() << where.getQuery();
+ *    // Output is: WHERE "age" BETWEEN ? AND ? AND "city" IN (?,?) AND ("name" LIKE ? OR "name" IS NULL)
+ * @endcode
+ */
+class SqliteWhere
+{
+public:
+    enum class Operator {
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        LESS_OR_EQUAL,
+        GREATER,
+        GREATER_OR_EQUAL,
+        IN, // The value must be a QVariantList
+        NOT_IN, // The value must be a QVariantList
+        BETWEEN, // The value must be a QVariantList with two items
+        LIKE,
+        IS_NULL, // The value is ignored
+        IS_NOT_NULL // The value is ignored
+    };
+
+public:
+    SqliteWhere();
+
+    /**
+     * @brief Adds a condition. If there are other conditions, it is joined with AND. This is the same as andWhere().
+     * @param columnName
+     * @param op
+     * @param value
+     * @return SqliteWhere &
+     */
+    SqliteWhere &where(const QString &columnName, Operator op, const QVariant &value = QVariant());
+    SqliteWhere &andWhere(const QString &columnName, Operator op, const QVariant &value = QVariant());
+    SqliteWhere &orWhere(const QString &columnName, Operator op, const QVariant &value = QVariant());
+
+    /**
+     * @brief Adds a condition on an SQL expression, e.g `lower(name)`. Unlike where(), the expression is used as is and not quoted. So
+     * it must never contain a user input, use the value for that.
+     * @param expression
+     * @param op
+     * @param value
+     * @return SqliteWhere &
+     */
+    SqliteWhere &whereExpression(const QString &expression, Operator op, const QVariant &value = QVariant());
+    SqliteWhere &andWhereExpression(const QString &expression, Operator op, const QVariant &value = QVariant());
+    SqliteWhere &orWhereExpression(const QString &expression, Operator op, const QVariant &value = QVariant());
+
+    /**
+     * @brief Adds the conditions of `group` in parentheses.
+     * @param group
+     * @return SqliteWhere &
+     */
+    SqliteWhere &andGroup(const SqliteWhere &group);
+    SqliteWhere &orGroup(const SqliteWhere &group);
+
+    bool isEmpty() const;
+
+    /**
+     * @brief Returns the conditions without the WHERE keyword.
+     * @return QString
+     */
+    QString getConditions() const;
+
+    /**
+     * @brief Returns the WHERE clause. If there are no conditions, returns an empty string.
+     * @return QString
+     */
+    QString getQuery() const;
+
+    /**
+     * @brief Returns the values in the order of the placeholders.
+     * @return QVariantList
+     */
+    QVariantList getBindValues() const;
+
+    static QString quoteIdentifier(const QString &identifier);
+
+private:
+    QString m_Conditions;
+    QVariantList m_BindValues;
+
+private:
+    /**
+     * @brief Appends a condition. `leftOperand` is used as is, the callers quote the column names.
+     */
+    SqliteWhere &append(const QString &joiner, const QString &leftOperand, Operator op, const QVariant &value);
+    SqliteWhere &appendGroup(const QString &joiner, const SqliteWhere &group);
+};
+
+}
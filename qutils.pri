@@ -1,5 +1,5 @@
 CONFIG += c++11
-QT += sql
+QT += sql concurrent
 
 contains(CONFIG, QUTILS_NO_MULTIMEDIA) {
     message("[qutils] Multimedia is disabled in qutils")
@@ -10,6 +10,32 @@ else {
     QT += multimedia
 }
 
+contains(CONFIG, QUTILS_ZLIB) {
+    # Links against the system zlib, which is not available on every kit (e.g MSVC, Android and iOS).
+    message("[qutils] zlib is enabled in qutils")
+    DEFINES += QUTILS_ZLIB
+    LIBS += -lz
+
+    HEADERS += \
+        $$PWD/include/qutils/GzipDevice.h
+
+    SOURCES += \
+        $$PWD/src/GzipDevice.cpp
+}
+
+contains(CONFIG, QUTILS_SQLITE_NATIVE) {
+    # Only enable this If Qt is built with -system-sqlite, the sqlite3 handles of Qt's driver are used with the system library.
+    message("[qutils] Native SQLite API is enabled in qutils")
+    DEFINES += QUTILS_SQLITE_NATIVE
+    LIBS += -lsqlite3
+
+    HEADERS += \
+        $$PWD/include/qutils/SqliteBlobDevice.h
+
+    SOURCES += \
+        $$PWD/src/SqliteBlobDevice.cpp
+}
+
 android {
     QT += androidextras
     OTHER_FILES += \
@@ -43,6 +69,14 @@ HEADERS += \
     $$PWD/include/qutils/TranslationHelper.h \
     $$PWD/include/qutils/NativeUtils.h \
     $$PWD/include/qutils/SqliteManager.h \
+    $$PWD/include/qutils/SqliteResultSet.h \
+    $$PWD/include/qutils/SqliteWhere.h \
+    $$PWD/include/qutils/SqliteAsyncExecutor.h \
+    $$PWD/include/qutils/SqliteConnectionPool.h \
+    $$PWD/include/qutils/SqliteMigrator.h \
+    $$PWD/include/qutils/SqliteTypedTable.h \
+    $$PWD/include/qutils/SqliteMaintenanceScheduler.h \
+    $$PWD/include/qutils/SqliteGroupCommitWriter.h \
     $$PWD/include/qutils/SettingsManager.h \
     $$PWD/include/qutils/CacheManager.h \
     $$PWD/include/qutils/Network/NetworkManager.h \
@@ -55,6 +89,13 @@ SOURCES += \
     $$PWD/src/TranslationHelper.cpp \
     $$PWD/src/NativeUtils.cpp \
     $$PWD/src/SqliteManager.cpp \
+    $$PWD/src/SqliteResultSet.cpp \
+    $$PWD/src/SqliteWhere.cpp \
+    $$PWD/src/SqliteAsyncExecutor.cpp \
+    $$PWD/src/SqliteConnectionPool.cpp \
+    $$PWD/src/SqliteMigrator.cpp \
+    $$PWD/src/SqliteMaintenanceScheduler.cpp \
+    $$PWD/src/SqliteGroupCommitWriter.cpp \
     $$PWD/src/SettingsManager.cpp \
     $$PWD/src/CacheManager.cpp \
     $$PWD/src/Network/NetworkManager.cpp \
@@ -10,7 +10,7 @@
 #define COL_CACHE_NAME "cache_name"
 #define COL_CACHE_VALUE "cache_value"
 #define COL_CACHE_TYPE "cache_type"
-#define DATABASE_CHECK() do { if (m_Database.isOpen() == false) { openDatabase(); createTable(); } } while (0)
+#define DATABASE_CHECK() do { if (m_Database.isOpen() == false) { openDatabase(); if (createTable() == false) { return {}; } } } while (0)
 
 namespace zmc
 {
@@ -25,6 +25,7 @@ CacheManager::CacheManager(QString databaseName, QString tableName, QObject *par
     , m_CacheTableName(tableName)
     , m_SqlManager()
     , m_Database()
+    , m_MaintenanceScheduler(nullptr)
 {
     m_Instances.append(this);
     m_InstanceLastIndex++;
@@ -39,29 +40,23 @@ bool CacheManager::write(const QString &key, const QVariant &value)
 {
     DATABASE_CHECK();
 
-    bool successful = false;
-    const QList<SqliteManager::Constraint> constraints {
-        std::make_tuple(COL_CACHE_NAME, key, "AND")
-    };
-
-    const QList<QMap<QString, QVariant>> existingData = m_SqlManager.getFromTable(m_Database, m_CacheTableName, -1, &constraints);
-    const bool exists = existingData.size() > 0;
     QMap<QString, QVariant> newMap;
     newMap[COL_CACHE_NAME] = key;
     newMap[COL_CACHE_VALUE] = value.toByteArray();
     newMap[COL_CACHE_TYPE] = QVariant::fromValue<int>(value.type());
 
-    if (exists) {
-        const QVariantMap oldMap = existingData.at(0);
-        successful = m_SqlManager.updateInTable(m_Database, m_CacheTableName, newMap, constraints);
-        QVariant oldValue = oldMap[COL_CACHE_VALUE];
-        oldValue.convert(oldMap[COL_CACHE_VALUE].toInt());
-
-        emitCacheChangedInAllInstances(key, oldMap[COL_CACHE_VALUE].toString(), newMap[COL_CACHE_VALUE].toString());
-    }
-    else {
-        successful = m_SqlManager.insertIntoTable(m_Database, m_CacheTableName, newMap);
-        emitCacheChangedInAllInstances(key, "", value);
+    // Reading the previous value costs another statement and a transaction, so it is only read when someone listens for the change.
+    const bool isOldValueNeeded = hasCacheChangedListeners();
+    QMap<QString, QVariant> oldMap;
+    const bool successful = m_SqlManager.upsertIntoTable(m_Database, m_CacheTableName, newMap, {COL_CACHE_NAME}, QStringList(),
+                            isOldValueNeeded ? &oldMap : nullptr);
+    if (successful && isOldValueNeeded) {
+        if (oldMap.size() > 0) {
+            emitCacheChangedInAllInstances(key, oldMap[COL_CACHE_VALUE].toString(), newMap[COL_CACHE_VALUE].toString());
+        }
+        else {
+            emitCacheChangedInAllInstances(key, "", value);
+        }
     }
 
     return successful;
@@ -146,7 +141,7 @@ QString CacheManager::getWritableLocation() const
     return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
 }
 
-void CacheManager::createTable()
+bool CacheManager::createTable()
 {
     DATABASE_CHECK();
 
@@ -157,12 +152,35 @@ void CacheManager::createTable()
     };
 
     m_SqlManager.createTable(m_Database, columns, m_CacheTableName);
+    // Every read and write looks up a row by its name, and the upsert in write() needs the names to be unique.
+    const SqliteManager::IndexDefinition index(m_CacheTableName + "_" + COL_CACHE_NAME + "_index", m_CacheTableName, {COL_CACHE_NAME}, true);
+    bool successful = m_SqlManager.hasIndex(m_Database, index.name);
+    if (successful == false) {
+        // Older databases did not enforce the uniqueness, only the newest row of a name is kept.
+        SqliteManager::Transaction transaction(m_SqlManager, m_Database);
+        const QString sqlQueryStr = "DELETE FROM " + m_CacheTableName + " WHERE rowid NOT IN (SELECT MAX(rowid) FROM " + m_CacheTableName +
+                                    " GROUP BY " + COL_CACHE_NAME + ")";
+        successful = transaction.isActive() && m_SqlManager.executeQuery(m_Database, sqlQueryStr) &&
+                     m_SqlManager.createIndex(m_Database, index) && transaction.commit();
+    }
+
+    if (successful == false) {
+        LOG_ERROR("Cannot create the unique index on " << m_CacheTableName << " in " << m_DatabaseName << ". Message: "
+                  << m_SqlManager.getLastError().error.text());
+        // The writes cannot work without the index, so the database is not used. The connection is not closed, other managers may
+        // be using it.
+        m_Database = QSqlDatabase();
+        emit databaseClosed();
+    }
+
+    return successful;
 }
 
 void CacheManager::openDatabase()
 {
     if (m_Database.isOpen() == false) {
         m_Database = m_SqlManager.openDatabase(m_DatabaseName);
+        startMaintenance();
         emit databaseOpened();
     }
 }
@@ -175,9 +193,39 @@ void CacheManager::restartDatabase()
     }
 
     m_Database = m_SqlManager.openDatabase(m_DatabaseName);
+    startMaintenance();
     emit databaseOpened();
 }
 
+void CacheManager::startMaintenance()
+{
+    delete m_MaintenanceScheduler;
+    m_MaintenanceScheduler = nullptr;
+    if (m_Database.isOpen() == false) {
+        return;
+    }
+
+    // Converting an existing file needs a VACUUM that rebuilds the whole file, which is too slow to run when the database is opened. So
+    // only a new file is switched to INCREMENTAL, the existing files keep their mode and only get the optimize and analyze steps.
+    if (m_SqlManager.getPageStats(m_Database).pageCount == 0 && m_SqlManager.setAutoVacuum(m_Database, "INCREMENTAL") == false) {
+        LOG_WARNING("Cannot enable incremental auto vacuum for " << m_DatabaseName);
+    }
+
+    m_MaintenanceScheduler = new SqliteMaintenanceScheduler(m_SqlManager, m_Database, SqliteMaintenanceScheduler::Options(), this);
+    m_MaintenanceScheduler->start();
+}
+
+bool CacheManager::hasCacheChangedListeners() const
+{
+    for (CacheManager *man : m_Instances) {
+        if (man && man->receivers(SIGNAL(cacheChanged(QString, QVariant, QVariant))) > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void CacheManager::emitCacheChangedInAllInstances(const QString &settingName, const QVariant &oldSettingValue, const QVariant &newCachedValue)
 {
     if (oldSettingValue != newCachedValue) {
@@ -0,0 +1,112 @@
+#include "qutils/GzipDevice.h"
+// qutils
+#include "qutils/Macros.h"
+// zlib
+#include <zlib.h>
+
+namespace zmc
+{
+
+GzipDevice::GzipDevice(QIODevice *target, int compressionLevel, QObject *parent)
+    : QIODevice(parent)
+    , m_Target(target)
+    , m_CompressionLevel(compressionLevel)
+    , m_Stream(nullptr)
+{
+
+}
+
+GzipDevice::~GzipDevice()
+{
+    if (isOpen()) {
+        close();
+    }
+}
+
+bool GzipDevice::open(OpenMode mode)
+{
+    if (mode != QIODevice::WriteOnly) {
+        LOG_ERROR("GzipDevice can only be opened with QIODevice::WriteOnly!");
+        return false;
+    }
+
+    if (m_Target == nullptr || m_Target->isWritable() == false) {
+        LOG_ERROR("Target device is not open for writing!");
+        return false;
+    }
+
+    m_Stream = new z_stream();
+    // 15 is the default window size, adding 16 writes a gzip header instead of a zlib header.
+    if (deflateInit2(m_Stream, m_CompressionLevel, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        LOG_ERROR("Cannot initialize the gzip stream. Message: " << m_Stream->msg);
+        delete m_Stream;
+        m_Stream = nullptr;
+        return false;
+    }
+
+    return QIODevice::open(mode);
+}
+
+void GzipDevice::close()
+{
+    if (m_Stream) {
+        if (deflateData(nullptr, 0, Z_FINISH) == false) {
+            LOG_ERROR("Cannot finish the gzip stream!");
+        }
+
+        deflateEnd(m_Stream);
+        delete m_Stream;
+        m_Stream = nullptr;
+    }
+
+    QIODevice::close();
+}
+
+bool GzipDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 GzipDevice::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 GzipDevice::writeData(const char *data, qint64 size)
+{
+    return deflateData(data, size, Z_NO_FLUSH) ? size : -1;
+}
+
+bool GzipDevice::deflateData(const char *data, qint64 size, int flush)
+{
+    char buffer[16384];
+    qint64 remaining = size;
+    do {
+        // avail_in is 32 bits wide, feed the bigger inputs in chunks.
+        const uInt chunkSize = static_cast<uInt>(qMin<qint64>(remaining, 1 << 30));
+        remaining -= chunkSize;
+        m_Stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        m_Stream->avail_in = chunkSize;
+        data += chunkSize;
+
+        const int chunkFlush = remaining > 0 ? Z_NO_FLUSH : flush;
+        do {
+            m_Stream->next_out = reinterpret_cast<Bytef *>(buffer);
+            m_Stream->avail_out = sizeof(buffer);
+            if (deflate(m_Stream, chunkFlush) == Z_STREAM_ERROR) {
+                return false;
+            }
+
+            const qint64 producedSize = static_cast<qint64>(sizeof(buffer) - m_Stream->avail_out);
+            if (producedSize > 0 && m_Target->write(buffer, producedSize) != producedSize) {
+                return false;
+            }
+        } while (m_Stream->avail_out == 0);
+    } while (remaining > 0);
+
+    return true;
+}
+
+}
@@ -10,7 +10,7 @@
 #define COL_SETTING_NAME "setting_name"
 #define COL_SETTING_VALUE "setting_value"
 #define COL_SETTING_TYPE "setting_type"
-#define DATABASE_CHECK() do { if (m_Database.isOpen() == false) { openDatabase(); createTable(); } } while (0)
+#define DATABASE_CHECK() do { if (m_Database.isOpen() == false) { openDatabase(); if (createTable() == false) { return {}; } } } while (0)
 
 namespace zmc
 {
@@ -52,29 +52,24 @@ bool SettingsManager::write(const QString &key, const QVariant &value)
 {
     DATABASE_CHECK();
 
-    bool successful = false;
-    const QList<SqliteManager::Constraint> values {
-        std::make_tuple(COL_SETTING_NAME, key, "AND")
-    };
-
-    const QList<QMap<QString, QVariant>> existingData = m_SqlManager.getFromTable(m_Database, m_SettingsTableName, -1, &values);
-    const bool exists = existingData.size() > 0;
     QMap<QString, QVariant> newMap;
     newMap[COL_SETTING_NAME] = key;
     newMap[COL_SETTING_VALUE] = value.toByteArray();
     newMap[COL_SETTING_TYPE] = QVariant::fromValue<int>(value.type());
 
-    if (exists) {
-        const QVariantMap oldMap = existingData.at(0);
-        successful = m_SqlManager.updateInTable(m_Database, m_SettingsTableName, newMap, values);
-        QVariant oldValue = oldMap[COL_SETTING_VALUE];
-        oldValue.convert(oldMap[COL_SETTING_VALUE].toInt());
+    // Reading the previous value costs another statement and a transaction, so it is only read when someone listens for the change.
+    const bool isOldValueNeeded = hasSettingChangedListeners();
+    QMap<QString, QVariant> oldMap;
+    const bool successful = m_SqlManager.upsertIntoTable(m_Database, m_SettingsTableName, newMap, {COL_SETTING_NAME}, QStringList(),
+                            isOldValueNeeded ? &oldMap : nullptr);
+    if (successful && isOldValueNeeded) {
+        QVariant oldEmittedValue = "";
+        if (oldMap.size() > 0) {
+            oldEmittedValue = oldMap[COL_SETTING_VALUE];
+            oldEmittedValue.convert(oldMap[COL_SETTING_VALUE].toInt());
+        }
 
-        emitSettingChangedInAllInstances(key, oldValue, value);
-    }
-    else {
-        successful = m_SqlManager.insertIntoTable(m_Database, m_SettingsTableName, newMap);
-        emitSettingChangedInAllInstances(key, "", value);
+        emitSettingChangedInAllInstances(key, oldEmittedValue, value);
     }
 
     return successful;
@@ -154,7 +149,7 @@ void SettingsManager::setSettingsTableName(const QString &tableName)
     createTable();
 }
 
-void SettingsManager::createTable()
+bool SettingsManager::createTable()
 {
     DATABASE_CHECK();
 
@@ -165,6 +160,28 @@ void SettingsManager::createTable()
     };
 
     m_SqlManager.createTable(m_Database, columns, m_SettingsTableName);
+    // Every read and write looks up a row by its name, and the upsert in write() needs the names to be unique.
+    const SqliteManager::IndexDefinition index(m_SettingsTableName + "_" + COL_SETTING_NAME + "_index", m_SettingsTableName, {COL_SETTING_NAME}, true);
+    bool successful = m_SqlManager.hasIndex(m_Database, index.name);
+    if (successful == false) {
+        // Older databases did not enforce the uniqueness, only the newest row of a name is kept.
+        SqliteManager::Transaction transaction(m_SqlManager, m_Database);
+        const QString sqlQueryStr = "DELETE FROM " + m_SettingsTableName + " WHERE rowid NOT IN (SELECT MAX(rowid) FROM " + m_SettingsTableName +
+                                    " GROUP BY " + COL_SETTING_NAME + ")";
+        successful = transaction.isActive() && m_SqlManager.executeQuery(m_Database, sqlQueryStr) &&
+                     m_SqlManager.createIndex(m_Database, index) && transaction.commit();
+    }
+
+    if (successful == false) {
+        LOG_ERROR("Cannot create the unique index on " << m_SettingsTableName << " in " << m_DatabaseName << ". Message: "
+                  << m_SqlManager.getLastError().error.text());
+        // The writes cannot work without the index, so the database is not used. The connection is not closed, other managers may
+        // be using it.
+        m_Database = QSqlDatabase();
+        emit databaseClosed();
+    }
+
+    return successful;
 }
 
 void SettingsManager::openDatabase()
@@ -186,6 +203,17 @@ void SettingsManager::restartDatabase()
     emit databaseOpened();
 }
 
+bool SettingsManager::hasSettingChangedListeners() const
+{
+    for (SettingsManager *man : m_Instances) {
+        if (man && man->receivers(SIGNAL(settingChanged(QString, QVariant, QVariant))) > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void SettingsManager::emitSettingChangedInAllInstances(const QString &settingName, const QVariant &oldSettingValue, const QVariant &newSettingValue)
 {
     if (oldSettingValue != newSettingValue) {
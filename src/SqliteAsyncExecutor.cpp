@@ -0,0 +1,133 @@
+#include "qutils/SqliteAsyncExecutor.h"
+// qutils
+#include "qutils/Macros.h"
+
+namespace zmc
+{
+
+SqliteAsyncExecutor::SqliteAsyncExecutor(const QString &databasePath)
+    : m_DatabasePath(databasePath)
+    , m_ConnectionName(databasePath + "_async_" + QString::number(reinterpret_cast<quintptr>(this), 16))
+    , m_SqlManager()
+    , m_Database()
+    , m_ThreadPool()
+{
+    // A single thread that never expires. The tasks are run in the order they are queued, and the connection always stays on the
+    // thread that created it.
+    m_ThreadPool.setMaxThreadCount(1);
+    m_ThreadPool.setExpiryTimeout(-1);
+}
+
+SqliteAsyncExecutor::~SqliteAsyncExecutor()
+{
+    // The connection has to be closed on the thread that opened it.
+    QtConcurrent::run(&m_ThreadPool, [this]() {
+        if (m_Database.isValid()) {
+            m_SqlManager.closeDatabase(m_Database);
+            m_Database = QSqlDatabase();
+            QSqlDatabase::removeDatabase(m_ConnectionName);
+        }
+    });
+
+    m_ThreadPool.waitForDone();
+}
+
+QString SqliteAsyncExecutor::getDatabasePath() const
+{
+    return m_DatabasePath;
+}
+
+QFuture<QList<QMap<QString, QVariant>>> SqliteAsyncExecutor::executeSelectQuery(const QString &sqlQueryStr, const QVariantList &bindValues)
+{
+    return run([sqlQueryStr, bindValues](SqliteManager &manager, QSqlDatabase &db) {
+        QList<QMap<QString, QVariant>> rows;
+        manager.forEachRow(db, sqlQueryStr, [&rows](const SqliteManager::Cursor &cursor) {
+            rows.append(cursor.getRow());
+            return true;
+        }, bindValues);
+
+        return rows;
+    });
+}
+
+QFuture<QList<QMap<QString, QVariant>>> SqliteAsyncExecutor::getFromTable(const QString &tableName, const SqliteWhere &where,
+        const unsigned int &limit)
+{
+    return run([tableName, where, limit](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.getFromTable(db, tableName, where, limit);
+    });
+}
+
+QFuture<bool> SqliteAsyncExecutor::insertIntoTable(const QString &tableName, const QMap<QString, QVariant> &row)
+{
+    return run([tableName, row](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.insertIntoTable(db, tableName, row);
+    });
+}
+
+QFuture<SqliteManager::BatchResult> SqliteAsyncExecutor::insertManyIntoTable(const QString &tableName,
+        const QList<QMap<QString, QVariant>> &rows)
+{
+    return run([tableName, rows](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.insertManyIntoTable(db, tableName, rows);
+    });
+}
+
+QFuture<bool> SqliteAsyncExecutor::updateInTable(const QString &tableName, const QMap<QString, QVariant> &row, const SqliteWhere &where)
+{
+    return run([tableName, row, where](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.updateInTable(db, tableName, row, where);
+    });
+}
+
+QFuture<bool> SqliteAsyncExecutor::deleteInTable(const QString &tableName, const SqliteWhere &where)
+{
+    return run([tableName, where](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.deleteInTable(db, tableName, where);
+    });
+}
+
+QFuture<bool> SqliteAsyncExecutor::exists(const QString &tableName, const SqliteWhere &where)
+{
+    return run([tableName, where](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.exists(db, tableName, where);
+    });
+}
+
+QFuture<bool> SqliteAsyncExecutor::backup(const QString &destinationPath, int pagesPerStep,
+        const SqliteManager::BackupProgressCallback &callback)
+{
+    return run([destinationPath, pagesPerStep, callback](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.backup(db, destinationPath, pagesPerStep, callback);
+    });
+}
+
+QFuture<bool> SqliteAsyncExecutor::vacuumInto(const QString &destinationPath)
+{
+    return run([destinationPath](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.vacuumInto(db, destinationPath);
+    });
+}
+
+void SqliteAsyncExecutor::waitForDone()
+{
+    // QThreadPool::waitForDone() also destroys the worker thread and the connection cannot be used from another thread. Since the
+    // tasks are run in order, waiting for an empty task is enough.
+    run([](SqliteManager &, QSqlDatabase &) {
+        return true;
+    }).waitForFinished();
+}
+
+QSqlDatabase &SqliteAsyncExecutor::getDatabase()
+{
+    if (m_Database.isOpen() == false) {
+        m_Database = m_SqlManager.openDatabase(m_DatabasePath, m_ConnectionName);
+        if (m_Database.isOpen() == false) {
+            LOG_ERROR("Cannot open the database at " << m_DatabasePath);
+        }
+    }
+
+    return m_Database;
+}
+
+}
@@ -0,0 +1,153 @@
+#include "qutils/SqliteBlobDevice.h"
+// Qt
+#include <QSqlDriver>
+// qutils
+#include "qutils/SqliteManager.h"
+#include "qutils/Macros.h"
+// sqlite
+#include <sqlite3.h>
+
+namespace zmc
+{
+
+SqliteBlobDevice::SqliteBlobDevice(const QSqlDatabase &database, const QString &tableName, const QString &columnName, qint64 rowID,
+                                   QObject *parent)
+    : QIODevice(parent)
+    , m_Database(database)
+    , m_TableName(tableName)
+    , m_ColumnName(columnName)
+    , m_RowID(rowID)
+    , m_Blob(nullptr)
+    , m_Size(0)
+{
+
+}
+
+SqliteBlobDevice::~SqliteBlobDevice()
+{
+    if (isOpen()) {
+        close();
+    }
+}
+
+bool SqliteBlobDevice::open(OpenMode mode)
+{
+    if (mode & (QIODevice::Append | QIODevice::Truncate)) {
+        LOG_ERROR("Append and Truncate are not supported, the size of a BLOB is fixed!");
+        return false;
+    }
+
+    sqlite3 *handle = nullptr;
+    if (m_Database.isOpen() && m_Database.driver()) {
+        const QVariant handleVar = m_Database.driver()->handle();
+        if (handleVar.isValid() && qstrcmp(handleVar.typeName(), "sqlite3*") == 0) {
+            handle = *static_cast<sqlite3 *const *>(handleVar.constData());
+        }
+    }
+
+    if (handle == nullptr) {
+        LOG_ERROR("Given database is not an open SQLite connection!");
+        return false;
+    }
+
+    const int flags = (mode & QIODevice::WriteOnly) ? 1 : 0;
+    const int status = sqlite3_blob_open(handle, "main", m_TableName.toUtf8().constData(), m_ColumnName.toUtf8().constData(), m_RowID,
+                                         flags, &m_Blob);
+    if (status != SQLITE_OK) {
+        setErrorString(QString::fromUtf8(sqlite3_errmsg(handle)));
+        LOG_ERROR("Cannot open the BLOB. Message: " << errorString());
+        m_Blob = nullptr;
+        return false;
+    }
+
+    m_Size = sqlite3_blob_bytes(m_Blob);
+    // The chunks are read from and written to SQLite directly, buffering them again is not needed.
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void SqliteBlobDevice::close()
+{
+    if (m_Blob) {
+        if (sqlite3_blob_close(m_Blob) != SQLITE_OK) {
+            LOG_ERROR("Error occurred while closing the BLOB of row " << m_RowID);
+        }
+
+        m_Blob = nullptr;
+        m_Size = 0;
+    }
+
+    QIODevice::close();
+}
+
+bool SqliteBlobDevice::reopen(qint64 rowID)
+{
+    if (m_Blob == nullptr) {
+        LOG_ERROR("Device is not open!");
+        return false;
+    }
+
+    if (sqlite3_blob_reopen(m_Blob, rowID) != SQLITE_OK) {
+        // The handle is aborted and cannot be used anymore.
+        setErrorString(QString("Cannot move to row %1").arg(rowID));
+        close();
+        return false;
+    }
+
+    m_RowID = rowID;
+    m_Size = sqlite3_blob_bytes(m_Blob);
+    return seek(0);
+}
+
+qint64 SqliteBlobDevice::size() const
+{
+    return m_Size;
+}
+
+qint64 SqliteBlobDevice::getRowID() const
+{
+    return m_RowID;
+}
+
+bool SqliteBlobDevice::preallocate(SqliteManager &manager, QSqlDatabase &database, const QString &tableName, const QString &columnName,
+                                   qint64 rowID, qint64 size)
+{
+    int rowsChanged = 0;
+    const QString sqlQueryStr = "UPDATE " + SqliteWhere::quoteIdentifier(tableName) + " SET " + SqliteWhere::quoteIdentifier(columnName) +
+                                " = zeroblob(?) WHERE rowid = ?";
+    return manager.executeQuery(database, sqlQueryStr, {size, rowID}, &rowsChanged) && rowsChanged == 1;
+}
+
+qint64 SqliteBlobDevice::readData(char *data, qint64 maxSize)
+{
+    const qint64 readSize = qMin(maxSize, m_Size - pos());
+    if (readSize <= 0) {
+        return readSize == 0 ? 0 : -1;
+    }
+
+    const int status = sqlite3_blob_read(m_Blob, data, static_cast<int>(readSize), static_cast<int>(pos()));
+    if (status != SQLITE_OK) {
+        setErrorString(QString::fromUtf8(sqlite3_errstr(status)));
+        return -1;
+    }
+
+    return readSize;
+}
+
+qint64 SqliteBlobDevice::writeData(const char *data, qint64 size)
+{
+    const qint64 writeSize = qMin(size, m_Size - pos());
+    if (writeSize <= 0) {
+        setErrorString("Cannot write past the end of the BLOB, preallocate a bigger BLOB.");
+        return -1;
+    }
+
+    const int status = sqlite3_blob_write(m_Blob, data, static_cast<int>(writeSize), static_cast<int>(pos()));
+    if (status != SQLITE_OK) {
+        setErrorString(QString::fromUtf8(sqlite3_errstr(status)));
+        return -1;
+    }
+
+    return writeSize;
+}
+
+}
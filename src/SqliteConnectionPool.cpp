@@ -0,0 +1,270 @@
+#include "qutils/SqliteConnectionPool.h"
+// Qt
+#include <QThread>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+// qutils
+#include "qutils/Macros.h"
+
+namespace zmc
+{
+
+SqliteConnectionPool::Connection::Connection(SqliteConnectionPool &pool, int timeout)
+    : m_Pool(pool)
+    , m_ThreadConnection(pool.acquire(timeout))
+{
+
+}
+
+SqliteConnectionPool::Connection::~Connection()
+{
+    if (m_ThreadConnection) {
+        m_Pool.release(m_ThreadConnection);
+    }
+}
+
+bool SqliteConnectionPool::Connection::isValid() const
+{
+    return m_ThreadConnection != nullptr;
+}
+
+QSqlDatabase &SqliteConnectionPool::Connection::getDatabase()
+{
+    Q_ASSERT(m_ThreadConnection);
+    return m_ThreadConnection->database;
+}
+
+SqliteManager &SqliteConnectionPool::Connection::getManager()
+{
+    Q_ASSERT(m_ThreadConnection);
+    return m_ThreadConnection->manager;
+}
+
+SqliteConnectionPool::SqliteConnectionPool(const QString &databasePath, int maxConnectionCount, const SqliteManager::OpenOptions &options)
+    : m_DatabasePath(databasePath)
+    , m_MaxConnectionCount(maxConnectionCount < 1 ? QThread::idealThreadCount() : maxConnectionCount)
+    , m_Options(options)
+    , m_Connections()
+    , m_Mutex()
+    , m_ConnectionReleased()
+    , m_WaitingCount(0)
+{
+    m_Options.journalMode = "WAL";
+    // Writers from other connections still lock each other out, wait for them instead of failing immediately.
+    if (m_Options.busyTimeout == SqliteManager::OpenOptions::UNSET) {
+        m_Options.busyTimeout = 5000;
+    }
+}
+
+SqliteConnectionPool::~SqliteConnectionPool()
+{
+    QThread *currentThread = QThread::currentThread();
+    QList<ThreadConnection *> ownConnections;
+    QMutexLocker locker(&m_Mutex);
+    for (ThreadConnection *threadConnection : m_Connections) {
+        if (threadConnection->referenceCount > 0) {
+            LOG_ERROR("Connection pool is destroyed while the connection " << threadConnection->connectionName << " is still in use!");
+        }
+
+        if (threadConnection->thread == currentThread) {
+            ownConnections.append(threadConnection);
+            continue;
+        }
+
+        // The connection cannot be closed from this thread, hand it over to its thread without referring to the pool anymore.
+        LOG_WARNING("Connection pool is destroyed while the thread of " << threadConnection->connectionName
+                    << " is running. It will be closed when the thread finishes.");
+        QObject::disconnect(threadConnection->threadFinishedConnection);
+        threadConnection->threadFinishedConnection = QObject::connect(threadConnection->thread, &QThread::finished,
+                                                                      threadConnection->context, [threadConnection]() {
+            close(threadConnection);
+        }, Qt::DirectConnection);
+    }
+
+    m_Connections.clear();
+    locker.unlock();
+
+    for (ThreadConnection *threadConnection : ownConnections) {
+        close(threadConnection);
+    }
+}
+
+QString SqliteConnectionPool::getDatabasePath() const
+{
+    return m_DatabasePath;
+}
+
+int SqliteConnectionPool::getMaxConnectionCount() const
+{
+    return m_MaxConnectionCount;
+}
+
+int SqliteConnectionPool::getOpenConnectionCount() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_Connections.size();
+}
+
+SqliteConnectionPool::ThreadConnection *SqliteConnectionPool::acquire(int timeout)
+{
+    QThread *thread = QThread::currentThread();
+    const Qt::HANDLE threadID = QThread::currentThreadId();
+    QMutexLocker locker(&m_Mutex);
+    ThreadConnection *threadConnection = m_Connections.value(thread, nullptr);
+    if (threadConnection && threadConnection->threadID != threadID) {
+        // An adopted thread that exited without emitting finished, and its QThread address is reused. The owner is gone, so it is
+        // closed here.
+        LOG_WARNING("Closing the connection " << threadConnection->connectionName << " of a thread that no longer exists.");
+        m_Connections.remove(thread);
+        locker.unlock();
+        close(threadConnection);
+        locker.relock();
+        threadConnection = nullptr;
+    }
+
+    if (threadConnection) {
+        threadConnection->referenceCount++;
+        return threadConnection;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    m_WaitingCount++;
+    while (m_Connections.size() >= m_MaxConnectionCount) {
+        // The idle connections are closed by their own threads, we can only ask for it.
+        requestEviction();
+        const qint64 remaining = timeout < 0 ? -1 : timeout - timer.elapsed();
+        if (timeout >= 0 && remaining <= 0) {
+            m_WaitingCount--;
+            LOG_ERROR("Timed out while waiting for a connection to " << m_DatabasePath);
+            return nullptr;
+        }
+
+        if (timeout < 0) {
+            m_ConnectionReleased.wait(&m_Mutex);
+        }
+        else {
+            m_ConnectionReleased.wait(&m_Mutex, static_cast<unsigned long>(remaining));
+        }
+    }
+
+    m_WaitingCount--;
+    // The slot is reserved before the connection is opened, so the other threads do not wait for us while we open it.
+    threadConnection = new ThreadConnection();
+    threadConnection->connectionName = m_DatabasePath + "_pool_" + QString::number(reinterpret_cast<quintptr>(this), 16) + "_" +
+                                       QString::number(reinterpret_cast<quintptr>(threadID), 16);
+    threadConnection->thread = thread;
+    threadConnection->threadID = threadID;
+    threadConnection->referenceCount = 1;
+    threadConnection->context = new QObject();
+    m_Connections.insert(thread, threadConnection);
+    locker.unlock();
+
+    if (open(threadConnection) == false) {
+        locker.relock();
+        m_Connections.remove(thread);
+        locker.unlock();
+        close(threadConnection);
+        m_ConnectionReleased.wakeAll();
+        return nullptr;
+    }
+
+    // The context lives in this thread and is deleted with the connection, so the slot cannot outlive the connection.
+    threadConnection->threadFinishedConnection = QObject::connect(thread, &QThread::finished, threadConnection->context, [this, thread]() {
+        onThreadFinished(thread);
+    }, Qt::DirectConnection);
+
+    return threadConnection;
+}
+
+void SqliteConnectionPool::release(ThreadConnection *threadConnection)
+{
+    QMutexLocker locker(&m_Mutex);
+    threadConnection->referenceCount--;
+    if (threadConnection->referenceCount > 0) {
+        return;
+    }
+
+    if (threadConnection->isEvictionRequested == false || m_WaitingCount == 0) {
+        // The connection stays open for the next lease of its thread.
+        threadConnection->isEvictionRequested = false;
+        return;
+    }
+
+    // release() is called from the owning thread, so the connection can be closed to make room for the waiting thread.
+    m_Connections.remove(threadConnection->thread);
+    locker.unlock();
+
+    close(threadConnection);
+    m_ConnectionReleased.wakeAll();
+}
+
+void SqliteConnectionPool::requestEviction()
+{
+    for (ThreadConnection *threadConnection : m_Connections) {
+        if (threadConnection->referenceCount == 0) {
+            threadConnection->isEvictionRequested = true;
+        }
+    }
+}
+
+void SqliteConnectionPool::onThreadFinished(QThread *thread)
+{
+    QMutexLocker locker(&m_Mutex);
+    ThreadConnection *threadConnection = m_Connections.value(thread, nullptr);
+    if (threadConnection == nullptr) {
+        return;
+    }
+
+    if (threadConnection->referenceCount > 0) {
+        // The lease still refers to it, closing it here would leave the lease dangling.
+        LOG_ERROR("The thread of the connection " << threadConnection->connectionName << " finished while the connection is leased!");
+        return;
+    }
+
+    m_Connections.remove(thread);
+    locker.unlock();
+
+    close(threadConnection);
+    m_ConnectionReleased.wakeAll();
+}
+
+void SqliteConnectionPool::close(ThreadConnection *threadConnection)
+{
+    QObject::disconnect(threadConnection->threadFinishedConnection);
+    const QString connectionName = threadConnection->connectionName;
+    if (threadConnection->database.isValid()) {
+        threadConnection->manager.closeDatabase(threadConnection->database);
+    }
+
+    // This may run inside a slot of the context, so it is not deleted right away. If its thread is gone, nothing would delete it later.
+    if (threadConnection->context->thread() == QThread::currentThread()) {
+        threadConnection->context->deleteLater();
+    }
+    else {
+        delete threadConnection->context;
+    }
+
+    delete threadConnection;
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+bool SqliteConnectionPool::open(ThreadConnection *threadConnection) const
+{
+    threadConnection->database = QSqlDatabase::addDatabase("QSQLITE", threadConnection->connectionName);
+    threadConnection->database.setDatabaseName(m_DatabasePath);
+    if (threadConnection->database.open() == false) {
+        LOG_ERROR("Cannot open the database at " << m_DatabasePath << ". Message: " << threadConnection->database.lastError().text());
+        return false;
+    }
+
+    if (threadConnection->manager.applyOpenOptions(threadConnection->database, m_Options) == false) {
+        LOG_ERROR("Cannot apply the options to " << m_DatabasePath << ". Message: "
+                  << threadConnection->manager.getLastError().error.text());
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,144 @@
+#include "qutils/SqliteGroupCommitWriter.h"
+// qutils
+#include "qutils/Macros.h"
+
+namespace zmc
+{
+
+SqliteGroupCommitWriter::SqliteGroupCommitWriter(SqliteManager &manager, const QSqlDatabase &database, int flushInterval,
+        int maxOperationCount, QObject *parent)
+    : QObject(parent)
+    , m_Manager(manager)
+    , m_Database(database)
+    , m_MaxOperationCount(qMax(maxOperationCount, 1))
+    , m_FlushTimer()
+    , m_PendingOperations()
+    , m_IsFlushDeferred(false)
+{
+    m_FlushTimer.setSingleShot(true);
+    m_FlushTimer.setInterval(flushInterval);
+    connect(&m_FlushTimer, &QTimer::timeout, this, &SqliteGroupCommitWriter::flush);
+}
+
+SqliteGroupCommitWriter::~SqliteGroupCommitWriter()
+{
+    flush();
+    // The group could not be flushed, e.g the writer is destroyed inside a transaction. The futures must not wait forever.
+    for (PendingOperation &pendingOperation : m_PendingOperations) {
+        pendingOperation.futureInterface.reportResult(false);
+        pendingOperation.futureInterface.reportFinished();
+    }
+}
+
+QFuture<bool> SqliteGroupCommitWriter::enqueue(const Operation &operation)
+{
+    PendingOperation pendingOperation;
+    pendingOperation.operation = operation;
+    pendingOperation.futureInterface.reportStarted();
+    const QFuture<bool> future = pendingOperation.futureInterface.future();
+
+    m_PendingOperations.append(pendingOperation);
+    if (m_PendingOperations.size() >= m_MaxOperationCount && m_IsFlushDeferred == false) {
+        flush();
+    }
+    else if (m_FlushTimer.isActive() == false) {
+        m_FlushTimer.start();
+    }
+
+    return future;
+}
+
+QFuture<bool> SqliteGroupCommitWriter::insertIntoTable(const QString &tableName, const QMap<QString, QVariant> &row)
+{
+    return enqueue([tableName, row](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.insertIntoTable(db, tableName, row);
+    });
+}
+
+QFuture<bool> SqliteGroupCommitWriter::upsertIntoTable(const QString &tableName, const QMap<QString, QVariant> &row,
+        const QStringList &conflictColumns)
+{
+    return enqueue([tableName, row, conflictColumns](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.upsertIntoTable(db, tableName, row, conflictColumns);
+    });
+}
+
+QFuture<bool> SqliteGroupCommitWriter::updateInTable(const QString &tableName, const QMap<QString, QVariant> &row, const SqliteWhere &where)
+{
+    return enqueue([tableName, row, where](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.updateInTable(db, tableName, row, where);
+    });
+}
+
+QFuture<bool> SqliteGroupCommitWriter::deleteInTable(const QString &tableName, const SqliteWhere &where)
+{
+    return enqueue([tableName, where](SqliteManager &manager, QSqlDatabase &db) {
+        return manager.deleteInTable(db, tableName, where);
+    });
+}
+
+bool SqliteGroupCommitWriter::flush()
+{
+    m_FlushTimer.stop();
+    if (m_PendingOperations.size() == 0) {
+        return true;
+    }
+
+    // Inside an open transaction our transaction would only be a savepoint, and the outer one could still roll the writes back. This is
+    // also the case when an operation of the group queues enough writes to trigger a flush. So the group waits for the next interval.
+    if (m_Manager.isInTransaction(m_Database)) {
+        if (m_IsFlushDeferred == false) {
+            LOG_WARNING("A transaction is open on the connection, flushing " << m_PendingOperations.size() << " writes is deferred.");
+        }
+
+        m_IsFlushDeferred = true;
+        m_FlushTimer.start();
+        return false;
+    }
+
+    m_IsFlushDeferred = false;
+    // The operations may queue new writes, those go to the next group.
+    QList<PendingOperation> operations;
+    operations.swap(m_PendingOperations);
+
+    QList<bool> results;
+    bool isCommitted = false;
+    {
+        SqliteManager::Transaction transaction(m_Manager, m_Database);
+        if (transaction.isActive()) {
+            for (const PendingOperation &pendingOperation : operations) {
+                // A failing write is rolled back to its savepoint when it goes out of scope.
+                SqliteManager::Transaction savepoint(m_Manager, m_Database);
+                const bool successful = savepoint.isActive() && pendingOperation.operation(m_Manager, m_Database) && savepoint.commit();
+                results.append(successful);
+            }
+
+            isCommitted = transaction.commit();
+        }
+    }
+
+    if (isCommitted == false) {
+        LOG_ERROR("Cannot commit the group of " << operations.size() << " writes. Message: " << m_Manager.getLastError().error.text());
+    }
+
+    for (int index = 0; index < operations.size(); index++) {
+        QFutureInterface<bool> &futureInterface = operations[index].futureInterface;
+        const bool result = isCommitted && results.value(index, false);
+        futureInterface.reportResult(result);
+        futureInterface.reportFinished();
+    }
+
+    emit flushed(operations.size(), isCommitted);
+    if (m_PendingOperations.size() > 0 && m_FlushTimer.isActive() == false) {
+        m_FlushTimer.start();
+    }
+
+    return isCommitted;
+}
+
+int SqliteGroupCommitWriter::getPendingCount() const
+{
+    return m_PendingOperations.size();
+}
+
+}
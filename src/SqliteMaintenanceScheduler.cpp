@@ -0,0 +1,95 @@
+#include "qutils/SqliteMaintenanceScheduler.h"
+// qutils
+#include "qutils/Macros.h"
+
+namespace zmc
+{
+
+SqliteMaintenanceScheduler::SqliteMaintenanceScheduler(SqliteManager &manager, const QSqlDatabase &database, const Options &options,
+        QObject *parent)
+    : QObject(parent)
+    , m_Manager(manager)
+    , m_Database(database)
+    , m_Options(options)
+    , m_Timer()
+    , m_OptimizeTimer()
+    , m_AnalyzeTimer()
+{
+    m_Timer.setInterval(m_Options.checkInterval);
+    connect(&m_Timer, &QTimer::timeout, this, &SqliteMaintenanceScheduler::onTimeout);
+}
+
+void SqliteMaintenanceScheduler::start()
+{
+    m_Timer.start();
+}
+
+void SqliteMaintenanceScheduler::stop()
+{
+    m_Timer.stop();
+}
+
+bool SqliteMaintenanceScheduler::isActive() const
+{
+    return m_Timer.isActive();
+}
+
+bool SqliteMaintenanceScheduler::runSlice()
+{
+    if (m_Database.isOpen() == false) {
+        return false;
+    }
+
+    // The maintenance statements must not make the connection look busy, otherwise the next slice would wait for them.
+    const bool isActivityTracked = m_Manager.isActivityTracked();
+    m_Manager.setActivityTracked(false);
+    QElapsedTimer sliceTimer;
+    sliceTimer.start();
+
+    bool successful = true;
+    int freedPageCount = 0;
+    SqliteManager::PageStats stats = m_Manager.getPageStats(m_Database);
+    if (stats.autoVacuum == "INCREMENTAL") {
+        while (stats.freelistCount > 0 && sliceTimer.elapsed() < m_Options.sliceDuration) {
+            const int freed = m_Manager.incrementalVacuum(m_Database, m_Options.pagesPerChunk);
+            if (freed <= 0) {
+                successful = freed == 0;
+                break;
+            }
+
+            freedPageCount += freed;
+            stats.freelistCount -= freed;
+        }
+    }
+
+    if (m_Options.optimizeInterval >= 0 && sliceTimer.elapsed() < m_Options.sliceDuration &&
+            (m_OptimizeTimer.isValid() == false || m_OptimizeTimer.elapsed() >= m_Options.optimizeInterval)) {
+        successful = m_Manager.optimize(m_Database) && successful;
+        m_OptimizeTimer.start();
+    }
+
+    if (m_Options.analyzeInterval >= 0 && sliceTimer.elapsed() < m_Options.sliceDuration &&
+            (m_AnalyzeTimer.isValid() == false || m_AnalyzeTimer.elapsed() >= m_Options.analyzeInterval)) {
+        successful = m_Manager.analyze(m_Database, m_Options.analysisLimit) && successful;
+        m_AnalyzeTimer.start();
+    }
+
+    m_Manager.setActivityTracked(isActivityTracked);
+    emit sliceFinished(freedPageCount, stats.freelistCount);
+    return successful;
+}
+
+void SqliteMaintenanceScheduler::onTimeout()
+{
+    const qint64 idleTime = m_Manager.getIdleTime(m_Database);
+    if (idleTime >= 0 && idleTime < m_Options.idleTime) {
+        return;
+    }
+
+    if (runSlice() == false) {
+        LOG_WARNING("Maintenance of " << m_Database.databaseName() << " failed. Message: "
+                    << m_Manager.getLastError().error.text());
+    }
+}
+
+}
@@ -3,425 +3,3245 @@
 // Qt
 #include <QSqlQuery>
 #include <QSqlRecord>
+#include <QSqlDriver>
+#include <QSqlResult>
+#include <QDataStream>
+#include <QScopedPointer>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QThread>
+#include <QAbstractEventDispatcher>
+#include <QRegExp>
+#include <QFile>
+// qutils
+#ifdef QUTILS_ZLIB
+#include "qutils/GzipDevice.h"
+#endif // QUTILS_ZLIB
+#ifdef QUTILS_SQLITE_NATIVE
+// sqlite
+#include <sqlite3.h>
+#endif // QUTILS_SQLITE_NATIVE
+// std
+#include <algorithm>
 
 namespace zmc
 {
 
-SqliteManager::SqliteManager()
-    : m_LastError()
+QString SqliteManager::Aggregate::getFunctionName() const
 {
+    switch (function) {
+    case AggregateFunction::COUNT:
+        return "COUNT";
+    case AggregateFunction::SUM:
+        return "SUM";
+    case AggregateFunction::TOTAL:
+        return "TOTAL";
+    case AggregateFunction::MIN:
+        return "MIN";
+    case AggregateFunction::MAX:
+        return "MAX";
+    case AggregateFunction::AVG:
+        return "AVG";
+    }
 
+    return QString();
 }
 
-QSqlDatabase SqliteManager::openDatabase(const QString &databasePath)
+QString SqliteManager::Aggregate::getAlias() const
 {
-    QSqlDatabase db;
-    if (QSqlDatabase::contains(databasePath)) {
-        db = QSqlDatabase::database(databasePath);
+    if (alias.isEmpty() == false) {
+        return alias;
     }
-    else {
-        db = QSqlDatabase::addDatabase("QSQLITE", databasePath);
-        db.setDatabaseName(databasePath);
-        if (db.open() == false) {
-            LOG_ERROR("Cannot open the database at " << databasePath);
-        }
+
+    const QString functionName = getFunctionName().toLower();
+    return column.isEmpty() ? functionName : functionName + "_" + column;
+}
+
+SqliteManager::Cursor::Cursor()
+    : m_Query()
+    , m_Record()
+    , m_IsValid(false)
+    , m_Manager(nullptr)
+    , m_SqlQueryStr()
+    , m_RowCount(0)
+    , m_FetchTime(0)
+{
+
+}
+
+SqliteManager::Cursor::Cursor(const QSqlQuery &query, SqliteManager *manager, const QString &sqlQueryStr)
+    : m_Query(query)
+    , m_Record(query.record())
+    , m_IsValid(true)
+    , m_Manager(manager)
+    , m_SqlQueryStr(sqlQueryStr)
+    , m_RowCount(0)
+    , m_FetchTime(0)
+{
+
+}
+
+SqliteManager::Cursor::Cursor(Cursor &&other)
+    : m_Query(other.m_Query)
+    , m_Record(other.m_Record)
+    , m_IsValid(other.m_IsValid)
+    , m_Manager(other.m_Manager)
+    , m_SqlQueryStr(other.m_SqlQueryStr)
+    , m_RowCount(other.m_RowCount)
+    , m_FetchTime(other.m_FetchTime)
+{
+    // The statement now belongs to this cursor, the other one must not reset it.
+    other.m_IsValid = false;
+    other.m_Manager = nullptr;
+}
+
+SqliteManager::Cursor::~Cursor()
+{
+    close();
+}
+
+SqliteManager::Cursor &SqliteManager::Cursor::operator=(Cursor &&other)
+{
+    if (this != &other) {
+        close();
+        m_Query = other.m_Query;
+        m_Record = other.m_Record;
+        m_IsValid = other.m_IsValid;
+        m_Manager = other.m_Manager;
+        m_SqlQueryStr = other.m_SqlQueryStr;
+        m_RowCount = other.m_RowCount;
+        m_FetchTime = other.m_FetchTime;
+        other.m_IsValid = false;
+        other.m_Manager = nullptr;
     }
 
-    return db;
+    return *this;
 }
 
-void SqliteManager::closeDatabase(QSqlDatabase &database)
+bool SqliteManager::Cursor::isValid() const
 {
-    database.close();
+    return m_IsValid;
 }
 
-bool SqliteManager::createTable(QSqlDatabase &database, const QList<ColumnDefinition> &columns, const QString &tableName)
+bool SqliteManager::Cursor::next()
 {
-    bool successful = false;
-    if (database.isOpen() == false) {
-        LOG_ERROR("Database is not open!");
-        return successful;
+    if (m_IsValid == false) {
+        return false;
     }
 
-    if (isTableExist(database, tableName)) {
-        LOG_ERROR("A table with the name " << tableName << " already exists in the database!");
-        return successful;
+    if (m_Manager == nullptr) {
+        return m_Query.next();
     }
 
-    QString sqlQueryStr = "CREATE TABLE \"main\".\"" + tableName + "\" (";
-    int index = 0;
-    for (const ColumnDefinition &def : columns) {
-        sqlQueryStr += "\"" + def.name + "\" " + getColumnTypeName(def.type) + " " + def.getNullText();
-        index++;
-        if (index < columns.size()) {
-            sqlQueryStr += ",";
-        }
+    QElapsedTimer timer;
+    timer.start();
+    const bool hasRow = m_Query.next();
+    m_FetchTime += timer.nsecsElapsed();
+    if (hasRow) {
+        m_RowCount++;
     }
 
-    // Add the ending parenthesis
-    sqlQueryStr += ")";
+    return hasRow;
+}
 
-    QSqlQuery query(database);
-    bool isExecSuccessful = query.exec(sqlQueryStr);
-    if (isExecSuccessful == false) {
-        updateError(database, sqlQueryStr);
-        LOG_ERROR("Error occurred. Message: " << database.lastError().text());
-        successful = false;
+void SqliteManager::Cursor::close()
+{
+    if (m_IsValid) {
+        m_Query.finish();
+        m_IsValid = false;
+        if (m_Manager) {
+            m_Manager->recordFetch(m_SqlQueryStr, m_RowCount, m_FetchTime / 1000);
+            m_Manager = nullptr;
+        }
     }
-    else {
-        LOG("Table \"" << tableName << "\" was succesffuly created!");
-        successful = true;
+}
+
+int SqliteManager::Cursor::getColumnCount() const
+{
+    return m_Record.count();
+}
+
+QStringList SqliteManager::Cursor::getColumnNames() const
+{
+    QStringList names;
+    for (int index = 0; index < m_Record.count(); index++) {
+        names.append(m_Record.fieldName(index));
     }
 
-    return successful;
+    return names;
 }
 
-bool SqliteManager::isTableExist(QSqlDatabase &database, const QString &tableName)
+QVariant SqliteManager::Cursor::value(int columnIndex) const
 {
-    bool isExist = false;
+    return m_Query.value(columnIndex);
+}
 
-    if (database.isOpen() == false) {
-        LOG_ERROR("Given database is not open!");
-        return isExist;
-    }
+QVariant SqliteManager::Cursor::value(const QString &columnName) const
+{
+    const int columnIndex = m_Record.indexOf(columnName);
+    return columnIndex == -1 ? QVariant() : m_Query.value(columnIndex);
+}
 
-    const QString sqlQueryStr = "SELECT COUNT(name) FROM sqlite_master WHERE type='table' AND name='" + tableName + "'";
-    QSqlQuery query(database);
-    bool successfull = query.exec(sqlQueryStr);
-    if (successfull == false) {
-        updateError(database, sqlQueryStr);
-        LOG_ERROR("Error occurred. Message: " << database.lastError().text());
-    }
-    else {
-        while (query.next()) {
-            const QVariant countVar = query.value(0);
-            if (countVar.isValid()) {
-                bool ok = false;
-                const int count = countVar.toInt(&ok);
-                if (ok && count == 1) {
-                    isExist = true;
-                }
-            }
-        }
+QMap<QString, QVariant> SqliteManager::Cursor::getRow() const
+{
+    QMap<QString, QVariant> row;
+    for (int index = 0; index < m_Record.count(); index++) {
+        row[m_Record.fieldName(index)] = m_Query.value(index);
     }
 
-    return isExist;
+    return row;
 }
 
-bool SqliteManager::dropTable(QSqlDatabase &database, const QString &tableName)
+SqliteManager::Transaction::Transaction(SqliteManager &manager, QSqlDatabase &database)
+    : m_Manager(manager)
+    , m_Database(database)
+    , m_SavepointName()
+    , m_IsActive(false)
 {
-    bool successful = false;
-    if (database.isOpen() == false) {
+    if (m_Database.isOpen() == false) {
         LOG_ERROR("Given database is not open!");
-        return successful;
+        return;
     }
 
-    if (isTableExist(database, tableName) == false) {
-        LOG_ERROR("Given table, " << tableName << ", does not exist!");
-        return successful;
+    // Savepoints are used for every level. Outside of a transaction a SAVEPOINT behaves like BEGIN, and the outermost RELEASE
+    // behaves like COMMIT. This way a Transaction also composes with a transaction that was started with QSqlDatabase::transaction().
+    // The depth is shared with the other managers of the connection, so their savepoint names do not clash with ours.
+    QSharedPointer<SharedConnectionState> shared = m_Manager.getConnectionState(m_Database).shared;
+    const int depth = shared ? shared->transactionDepth : 0;
+    m_SavepointName = "qutils_savepoint_" + QString::number(depth);
+    m_IsActive = execute("SAVEPOINT " + m_SavepointName);
+    if (m_IsActive && shared) {
+        shared->transactionDepth++;
     }
+}
 
-    const QString sqlQueryStr = "DROP TABLE " + tableName;
-    QSqlQuery query(database);
-    bool successfull = query.exec(sqlQueryStr);
-    if (successfull == false) {
-        updateError(database, sqlQueryStr);
-        LOG_ERROR("Error occurred. Message: " << database.lastError().text());
+SqliteManager::Transaction::~Transaction()
+{
+    if (m_IsActive) {
+        rollback();
+    }
+}
+
+bool SqliteManager::Transaction::isActive() const
+{
+    return m_IsActive;
+}
+
+bool SqliteManager::Transaction::commit()
+{
+    if (m_IsActive == false) {
+        LOG_ERROR("Transaction is not active!");
+        return false;
+    }
+
+    const bool successful = execute("RELEASE SAVEPOINT " + m_SavepointName);
+    if (successful) {
+        finish();
     }
     else {
-        successful = true;
+        rollback();
     }
 
     return successful;
 }
 
-QString SqliteManager::constructWhereQuery(const QList<SqliteManager::Constraint> &values)
+bool SqliteManager::Transaction::rollback()
 {
-    QString query = "WHERE ";
-    int index = 0;
-    for (const auto &t : values) {
-        if (index != 0) {
-            query += " ";
-        }
+    if (m_IsActive == false) {
+        LOG_ERROR("Transaction is not active!");
+        return false;
+    }
 
-        query += std::get<0>(t) + "='" + std::get<1>(t) + "'";
-        if (index < values.size() - 1) {
-            query += " " + std::get<2>(t);
-        }
+    // ROLLBACK TO leaves the savepoint on the stack, so it has to be released as well.
+    const bool successful = execute("ROLLBACK TO SAVEPOINT " + m_SavepointName) && execute("RELEASE SAVEPOINT " + m_SavepointName);
+    // The results cached inside the transaction may contain the rolled back changes.
+    m_Manager.invalidateResultCache(m_Database);
+    finish();
+    return successful;
+}
 
-        index++;
+bool SqliteManager::Transaction::execute(const QString &sqlQueryStr)
+{
+    QSqlQuery query;
+    bool successful = m_Manager.prepareQuery(m_Database, sqlQueryStr, query);
+    if (successful) {
+        successful = m_Manager.execQuery(query, sqlQueryStr);
+        query.finish();
     }
 
-    return query;
+    return successful;
 }
 
-QList<QMap<QString, QVariant> > SqliteManager::executeSelectQuery(QSqlDatabase &database, const QString &sqlQueryStr)
+void SqliteManager::Transaction::finish()
 {
-    QList<QMap<QString, QVariant>> resultList;
-    if (database.isOpen() == false) {
-        LOG_ERROR("Given database is not open!");
-        return resultList;
+    m_IsActive = false;
+    QSharedPointer<SharedConnectionState> shared = m_Manager.getConnectionState(m_Database).shared;
+    if (shared && shared->transactionDepth > 0) {
+        shared->transactionDepth--;
+        if (shared->transactionDepth == 0) {
+            // The other connections' commits are visible again.
+            shared->isDataVersionChecked = false;
+        }
     }
+}
 
-    QSqlQuery query(database);
-    if (query.exec(sqlQueryStr) == false) {
-        updateError(database, sqlQueryStr);
-        LOG_ERROR("Error occurred. Message: " << database.lastError().text());
+QList<SqliteManager::QueryPlanStep> SqliteManager::QueryPlan::getChildren(int parentID) const
+{
+    QList<QueryPlanStep> children;
+    for (const QueryPlanStep &step : steps) {
+        if (step.parentID == parentID) {
+            children.append(step);
+        }
     }
-    else {
-        while (query.next()) {
-            const QSqlRecord record = query.record();
-            const unsigned int count = record.count();
-            QVariantMap resultMap;
-            for (unsigned int columnIndex = 0; columnIndex < count; columnIndex++) {
-                resultMap[record.fieldName(columnIndex)] = record.value(columnIndex);
-            }
 
-            resultList.append(resultMap);
+    return children;
+}
+
+bool SqliteManager::QueryPlan::isUsingIndex() const
+{
+    for (const QueryPlanStep &step : steps) {
+        // e.g "SEARCH cache USING INDEX cache_name_index (cache_name=?)" or "SEARCH t USING INTEGER PRIMARY KEY (rowid=?)"
+        if (step.detail.contains("USING INDEX") || step.detail.contains("USING COVERING INDEX") ||
+                step.detail.contains("PRIMARY KEY")) {
+            return true;
         }
     }
 
-    return resultList;
+    return false;
 }
 
-QList<QMap<QString, QVariant> > SqliteManager::getFromTable(QSqlDatabase &database, const QString &tableName, const unsigned int &limit,
-        const QList<Constraint> *constraints, const SelectOrder *selectOrder)
+bool SqliteManager::QueryPlan::hasFullScan() const
 {
-    if (database.isOpen() == false) {
-        LOG_ERROR("Given database is not open!");
-        return QList<QMap<QString, QVariant>>();
+    for (const QueryPlanStep &step : steps) {
+        // Older versions of SQLite print "SCAN TABLE cache", newer ones "SCAN cache".
+        if (step.detail.startsWith("SCAN") && step.detail.contains("INDEX") == false && step.detail.contains("CONSTANT ROW") == false) {
+            return true;
+        }
     }
 
-    if (isTableExist(database, tableName) == false) {
-        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
-        return QList<QMap<QString, QVariant>>();
-    }
+    return false;
+}
 
-    QString sqlQueryStr = "SELECT * FROM " + tableName;
-    if (constraints && constraints->size() > 0) {
-        sqlQueryStr += " " + constructWhereQuery(*constraints);
+QString SqliteManager::QueryPlan::toString() const
+{
+    QStringList lines;
+    for (const QueryPlanStep &step : steps) {
+        lines.append(QString(step.depth * 2, ' ') + "|--" + step.detail);
     }
 
-    if (selectOrder && selectOrder->fieldName.length() > 0) {
-        const QString orderType = selectOrder->order == SelectOrder::OrderType::ASC ? "ASC" : "DESC";
-        sqlQueryStr += " ORDER BY " + selectOrder->fieldName + " " + orderType;
-    }
+    return lines.join('\n');
+}
 
-    if (limit > 0) {
-        sqlQueryStr += " LIMIT " + QString::number(limit);
+SqliteManager::OpenOptions SqliteManager::OpenOptions::getPreset(const QString &name)
+{
+    OpenOptions options;
+    if (name == "durable") {
+        options.presetName = name;
+        options.journalMode = "WAL";
+        options.synchronous = "FULL";
+        options.busyTimeout = 5000;
+        options.foreignKeys = 1;
+    }
+    else if (name == "fast-cache") {
+        options.presetName = name;
+        options.journalMode = "WAL";
+        options.synchronous = "OFF";
+        options.cacheSize = -16384;
+        options.tempStore = "MEMORY";
+        options.busyTimeout = 5000;
+        options.autoVacuum = "INCREMENTAL";
+    }
+    else if (name == "read-mostly") {
+        options.presetName = name;
+        options.journalMode = "WAL";
+        options.synchronous = "NORMAL";
+        options.cacheSize = -32768;
+        options.mmapSize = 256 * 1024 * 1024;
+        options.tempStore = "MEMORY";
+        options.busyTimeout = 5000;
+    }
+    else {
+        LOG_WARNING("Unknown preset " << name << ". Default options are used.");
     }
 
-    return executeSelectQuery(database, sqlQueryStr);
+    return options;
 }
 
-bool SqliteManager::insertIntoTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row)
+QVariantMap SqliteManager::OpenOptions::toMap() const
 {
-    bool successful = false;
-    if (database.isOpen() == false) {
-        LOG_ERROR("Given database is not open!");
-        return successful;
-    }
+    QVariantMap map;
+    map["preset"] = presetName;
+    map["journal_mode"] = journalMode;
+    map["synchronous"] = synchronous;
+    map["temp_store"] = tempStore;
+    map["cache_size"] = cacheSize == UNSET ? QVariant() : QVariant(cacheSize);
+    map["page_size"] = pageSize == UNSET ? QVariant() : QVariant(pageSize);
+    map["busy_timeout"] = busyTimeout == UNSET ? QVariant() : QVariant(busyTimeout);
+    map["foreign_keys"] = foreignKeys == UNSET ? QVariant() : QVariant(foreignKeys);
+    map["mmap_size"] = mmapSize < 0 ? QVariant() : QVariant(mmapSize);
+    map["auto_vacuum"] = autoVacuum;
+
+    return map;
+}
 
-    if (isTableExist(database, tableName) == false) {
-        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
-        return successful;
-    }
+QVariantMap SqliteManager::QueryStats::toMap() const
+{
+    QVariantMap map;
+    map["query"] = query;
+    map["call_count"] = callCount;
+    map["failed_count"] = failedCount;
+    map["total_time"] = totalTime;
+    map["mean_time"] = getMeanTime();
+    map["p95_time"] = p95Time;
+    map["max_time"] = maxTime;
+    map["fetch_time"] = fetchTime;
+    map["rows_returned"] = rowsReturned;
+    map["rows_changed"] = rowsChanged;
+    return map;
+}
 
-    QSqlQuery query(database);
-    QString sqlQueryStr = "INSERT INTO " + tableName + " ";
-    QStringList columnNames, valuePlaceholders;
-    for (auto it = row.constBegin(); it != row.constEnd(); it++) {
-        columnNames.append(it.key());
-        valuePlaceholders.append(":" + it.key());
-    }
+SqliteManager::SqliteManager()
+    : m_LastError()
+    , m_Connections()
+    , m_StatementCacheCapacity(32)
+    , m_ResultCacheCapacity(0)
+    , m_IsQueryStatsEnabled(true)
+    , m_QueryStats()
+    , m_NormalizedQueries()
+    , m_SlowQueryThreshold(-1)
+    , m_SlowQueryCallback()
+    , m_IsActivityTracked(true)
+{
 
-    sqlQueryStr.append("(" + columnNames.join(',') + ") ");
-    sqlQueryStr.append("VALUES(" + valuePlaceholders.join(',') + ")");
-    query.prepare(sqlQueryStr);
+}
 
-    // Now bind the values
-    for (auto it = row.constBegin(); it != row.constEnd(); it++) {
-        query.bindValue(":" + it.key(), it.value());
+bool SqliteManager::isInTransaction(QSqlDatabase &database)
+{
+    const ConnectionState &state = getConnectionState(database);
+#ifdef QUTILS_SQLITE_NATIVE
+    if (state.handle) {
+        return sqlite3_get_autocommit(static_cast<sqlite3 *>(state.handle)) == 0;
     }
+#endif // QUTILS_SQLITE_NATIVE
 
-    if (query.exec() == false) {
-        updateError(database, sqlQueryStr);
-        LOG_ERROR("Error occurred. Message: " << database.lastError().text() << ". Query: " << query.executedQuery());
+    return state.shared && state.shared->transactionDepth > 0;
+}
+
+QSqlDatabase SqliteManager::openDatabase(const QString &databasePath)
+{
+    return openDatabase(databasePath, databasePath);
+}
+
+QSqlDatabase SqliteManager::openDatabase(const QString &databasePath, const QString &connectionName)
+{
+    QSqlDatabase db;
+    if (QSqlDatabase::contains(connectionName)) {
+        db = QSqlDatabase::database(connectionName);
     }
     else {
-        successful = true;
+        db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(databasePath);
+        if (db.open() == false) {
+            LOG_ERROR("Cannot open the database at " << databasePath);
+        }
     }
 
-    return successful;
+    return db;
 }
 
-bool SqliteManager::updateInTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row, const QList<Constraint> &constraints)
+QSqlDatabase SqliteManager::openDatabase(const QString &databasePath, const OpenOptions &options, OpenOptions *appliedOptions, bool *ok)
 {
-    bool successful = false;
-    if (database.isOpen() == false) {
-        LOG_ERROR("Given database is not open!");
-        return successful;
-    }
+    QSqlDatabase db = openDatabase(databasePath);
+    if (db.isOpen() == false) {
+        if (ok) {
+            *ok = false;
+        }
 
-    if (isTableExist(database, tableName) == false) {
-        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
-        return successful;
+        return db;
     }
 
-    QSqlQuery query(database);
-    QString sqlQueryStr = "UPDATE " + tableName + " SET ";
-    QStringList newValues;
-    for (auto it = row.constBegin(); it != row.constEnd(); it++) {
-        newValues.append(it.key() + "=" + ":" + it.key());
+    // The connection is shared by name with the other managers of the same file, so it is not closed when the options fail.
+    const bool isApplied = applyOpenOptions(db, options);
+    if (isApplied == false) {
+        LOG_ERROR("Cannot apply the options to the database at " << databasePath << ". Message: " << m_LastError.error.text());
     }
 
-    sqlQueryStr.append(newValues.join(','));
-    sqlQueryStr.append(" " + constructWhereQuery(constraints));
-
-    query.prepare(sqlQueryStr);
-    // Now bind the values
-    for (auto it = row.constBegin(); it != row.constEnd(); it++) {
-        query.bindValue(":" + it.key(), it.value());
+    if (ok) {
+        *ok = isApplied;
     }
 
-    if (query.exec() == false) {
-        updateError(database, sqlQueryStr);
-        LOG_ERROR("Error occurred. Message: " << database.lastError().text());
-    }
-    else {
-        successful = true;
+    if (appliedOptions) {
+        *appliedOptions = readOpenOptions(db);
+        appliedOptions->presetName = options.presetName;
     }
 
-    return successful;
+    return db;
 }
 
-bool SqliteManager::deleteInTable(QSqlDatabase &database, const QString &tableName, const QList<Constraint> &constraints)
+bool SqliteManager::applyOpenOptions(QSqlDatabase &database, const OpenOptions &options)
 {
-    bool successful = false;
     if (database.isOpen() == false) {
         LOG_ERROR("Given database is not open!");
-        return successful;
+        return false;
     }
 
-    if (isTableExist(database, tableName) == false) {
-        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
-        return successful;
+    QStringList pragmas;
+    // The page size must be set before the journal mode, because it cannot be changed once the database is in WAL mode.
+    if (options.pageSize != OpenOptions::UNSET) {
+        pragmas.append("page_size=" + QString::number(options.pageSize));
     }
 
-    QSqlQuery query(database);
-    QString sqlQueryStr = "DELETE FROM " + tableName + " ";
-    sqlQueryStr.append(constructWhereQuery(constraints));
+    if (options.autoVacuum.isEmpty() == false) {
+        pragmas.append("auto_vacuum=" + options.autoVacuum);
+    }
 
-    if (query.exec(sqlQueryStr) == false) {
-        updateError(database, sqlQueryStr);
-        LOG_ERROR("Error occurred. Message: " << database.lastError().text());
+    if (options.journalMode.isEmpty() == false) {
+        pragmas.append("journal_mode=" + options.journalMode);
     }
-    else {
-        successful = true;
+
+    if (options.synchronous.isEmpty() == false) {
+        pragmas.append("synchronous=" + options.synchronous);
+    }
+
+    if (options.cacheSize != OpenOptions::UNSET) {
+        pragmas.append("cache_size=" + QString::number(options.cacheSize));
+    }
+
+    if (options.mmapSize >= 0) {
+        pragmas.append("mmap_size=" + QString::number(options.mmapSize));
+    }
+
+    if (options.tempStore.isEmpty() == false) {
+        pragmas.append("temp_store=" + options.tempStore);
+    }
+
+    if (options.busyTimeout != OpenOptions::UNSET) {
+        pragmas.append("busy_timeout=" + QString::number(options.busyTimeout));
+    }
+
+    if (options.foreignKeys != OpenOptions::UNSET) {
+        pragmas.append("foreign_keys=" + QString::number(options.foreignKeys));
+    }
+
+    // name=value of the pragmas that are already applied, with their previous values.
+    QStringList previousValues;
+    bool successful = true;
+    for (const QString &pragma : pragmas) {
+        const QString name = pragma.section('=', 0, 0);
+        bool ok = false;
+        const QVariant previousValue = executePragma(database, name, &ok);
+        const QVariant result = ok ? executePragma(database, pragma, &ok) : QVariant();
+        if (ok == false) {
+            successful = false;
+            break;
+        }
+
+        previousValues.prepend(name + "=" + previousValue.toString());
+        // journal_mode reports the mode that is in effect, it does not fail when the mode cannot be changed.
+        if (name == "journal_mode" && result.toString().compare(options.journalMode, Qt::CaseInsensitive) != 0) {
+            m_LastError.error = QSqlError("journal_mode is " + result.toString(), "", QSqlError::StatementError);
+            m_LastError.query = "PRAGMA " + pragma;
+            successful = false;
+            break;
+        }
+    }
+
+    if (successful == false) {
+        // Restore in the reverse order, so a failed preset does not leave the connection half configured.
+        const SqliteError error = m_LastError;
+        for (const QString &pragma : previousValues) {
+            executePragma(database, pragma);
+        }
+
+        m_LastError = error;
     }
 
     return successful;
 }
 
-bool SqliteManager::exists(QSqlDatabase &database, const QString &tableName, const QList<Constraint> &constraints)
+SqliteManager::OpenOptions SqliteManager::readOpenOptions(QSqlDatabase &database)
 {
-    bool exists = false;
+    OpenOptions options;
     if (database.isOpen() == false) {
         LOG_ERROR("Given database is not open!");
-        return exists;
+        return options;
     }
 
-    if (isTableExist(database, tableName) == false) {
-        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
-        return exists;
+    const QStringList synchronousNames {"OFF", "NORMAL", "FULL", "EXTRA"};
+    const QStringList tempStoreNames {"DEFAULT", "FILE", "MEMORY"};
+    options.journalMode = executePragma(database, "journal_mode").toString().toUpper();
+    options.synchronous = synchronousNames.value(executePragma(database, "synchronous").toInt());
+    options.tempStore = tempStoreNames.value(executePragma(database, "temp_store").toInt());
+    options.cacheSize = executePragma(database, "cache_size").toInt();
+    options.pageSize = executePragma(database, "page_size").toInt();
+    options.busyTimeout = executePragma(database, "busy_timeout").toInt();
+    options.foreignKeys = executePragma(database, "foreign_keys").toInt();
+    options.mmapSize = executePragma(database, "mmap_size").toLongLong();
+    options.autoVacuum = QStringList({"NONE", "FULL", "INCREMENTAL"}).value(executePragma(database, "auto_vacuum").toInt());
+
+    return options;
+}
+
+void SqliteManager::closeDatabase(QSqlDatabase &database)
+{
+#ifdef QUTILS_SQLITE_NATIVE
+    // The other managers may still hold the shared state, but the handle is going away.
+    auto it = m_Connections.find(database.connectionName());
+    if (it != m_Connections.end() && it.value().shared && it.value().shared->isUpdateHookInstalled) {
+        sqlite3_update_hook(static_cast<sqlite3 *>(it.value().handle), nullptr, nullptr);
+        it.value().shared->isUpdateHookInstalled = false;
     }
+#endif // QUTILS_SQLITE_NATIVE
 
-    if (constraints.size() == 0) {
-        LOG_ERROR("Constraints size cannot be 0!");
-        return exists;
+    // Cached statements must be finalized before the connection is closed.
+    m_Connections.remove(database.connectionName());
+    database.close();
+}
+
+bool SqliteManager::backup(QSqlDatabase &source, const QString &destinationPath, int pagesPerStep,
+                           const BackupProgressCallback &callback, int sleepBetweenSteps)
+{
+#ifdef QUTILS_SQLITE_NATIVE
+    sqlite3 *sourceHandle = static_cast<sqlite3 *>(getHandle(source));
+    if (sourceHandle == nullptr) {
+        LOG_ERROR("Given database is not open!");
+        return false;
+    }
+
+    const QString temporaryPath = destinationPath + ".backup";
+    QFile::remove(temporaryPath);
+    sqlite3 *destinationHandle = nullptr;
+    if (sqlite3_open_v2(temporaryPath.toUtf8().constData(), &destinationHandle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) !=
+            SQLITE_OK) {
+        LOG_ERROR("Cannot open the backup file at " << temporaryPath << ". Message: " << sqlite3_errmsg(destinationHandle));
+        sqlite3_close(destinationHandle);
+        return false;
+    }
+
+    bool successful = false;
+    sqlite3_backup *backupHandle = sqlite3_backup_init(destinationHandle, "main", sourceHandle, "main");
+    if (backupHandle) {
+        int status = SQLITE_OK;
+        do {
+            status = sqlite3_backup_step(backupHandle, pagesPerStep < 1 ? -1 : pagesPerStep);
+            if (callback) {
+                BackupProgress progress;
+                progress.remainingPageCount = sqlite3_backup_remaining(backupHandle);
+                progress.totalPageCount = sqlite3_backup_pagecount(backupHandle);
+                if (callback(progress) == false) {
+                    LOG("Backup to " << destinationPath << " is cancelled.");
+                    break;
+                }
+            }
+
+            // The source is locked by someone else, try the same step again after a while.
+            if (status == SQLITE_OK || status == SQLITE_BUSY || status == SQLITE_LOCKED) {
+                QThread::msleep(static_cast<unsigned long>(qMax(sleepBetweenSteps, 1)));
+            }
+        } while (status == SQLITE_OK || status == SQLITE_BUSY || status == SQLITE_LOCKED);
+
+        successful = status == SQLITE_DONE;
+        sqlite3_backup_finish(backupHandle);
+    }
+
+    if (successful == false) {
+        LOG_ERROR("Backup to " << destinationPath << " failed. Message: " << sqlite3_errmsg(destinationHandle));
+    }
+
+    sqlite3_close(destinationHandle);
+    if (successful) {
+        QFile::remove(destinationPath);
+        successful = QFile::rename(temporaryPath, destinationPath);
+    }
+    else {
+        QFile::remove(temporaryPath);
+    }
+
+    return successful;
+#else
+    Q_UNUSED(pagesPerStep);
+    Q_UNUSED(sleepBetweenSteps);
+    LOG_WARNING("qutils is built without QUTILS_SQLITE_NATIVE, the backup is taken with VACUUM INTO.");
+    const bool successful = vacuumInto(source, destinationPath);
+    if (successful && callback) {
+        BackupProgress progress;
+        progress.totalPageCount = 1;
+        callback(progress);
+    }
+
+    return successful;
+#endif // QUTILS_SQLITE_NATIVE
+}
+
+bool SqliteManager::vacuumInto(QSqlDatabase &source, const QString &destinationPath)
+{
+    if (source.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return false;
     }
 
-    const QString sqlQueryStr = "SELECT COUNT(rowid) FROM " + tableName + " " + constructWhereQuery(constraints);
+    // VACUUM INTO refuses to overwrite a file, and the existing file should only be replaced by a complete copy.
+    const QString temporaryPath = destinationPath + ".backup";
+    QFile::remove(temporaryPath);
+    bool successful = executeQuery(source, "VACUUM INTO ?", QVariantList{temporaryPath});
+    if (successful) {
+        QFile::remove(destinationPath);
+        successful = QFile::rename(temporaryPath, destinationPath);
+    }
+    else {
+        QFile::remove(temporaryPath);
+    }
+
+    return successful;
+}
+
+bool SqliteManager::createTable(QSqlDatabase &database, const QList<ColumnDefinition> &columns, const QString &tableName)
+{
+    bool successful = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Database is not open!");
+        return successful;
+    }
+
+    if (isTableExist(database, tableName)) {
+        LOG_ERROR("A table with the name " << tableName << " already exists in the database!");
+        return successful;
+    }
+
+    QString sqlQueryStr = "CREATE TABLE \"main\".\"" + tableName + "\" (";
+    int index = 0;
+    for (const ColumnDefinition &def : columns) {
+        sqlQueryStr += "\"" + def.name + "\" " + getColumnTypeName(def.type) + " " + def.getNullText();
+        index++;
+        if (index < columns.size()) {
+            sqlQueryStr += ",";
+        }
+    }
+
+    // Add the ending parenthesis
+    sqlQueryStr += ")";
+
     QSqlQuery query(database);
-    bool successfull = query.exec(sqlQueryStr);
-    if (successfull == false) {
+    bool isExecSuccessful = query.exec(sqlQueryStr);
+    if (isExecSuccessful == false) {
         updateError(database, sqlQueryStr);
-        LOG_ERROR("Error occurred. Message: " << database.lastError().text() << ". Query: " << sqlQueryStr);
+        LOG_ERROR("Error occurred. Message: " << database.lastError().text());
+        successful = false;
     }
     else {
-        query.first();
-        const int count = query.value(0).toInt();
-        exists = count > 0;
+        LOG("Table \"" << tableName << "\" was succesffuly created!");
+        updateSchemaCache(database, tableName, columns, false);
+        successful = true;
     }
 
-    return exists;
+    return successful;
 }
 
-const SqliteManager::SqliteError &SqliteManager::getLastError() const
+bool SqliteManager::isTableExist(QSqlDatabase &database, const QString &tableName)
 {
-    return m_LastError;
+    bool isExist = false;
+
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return isExist;
+    }
+
+    if (refreshSchemaCache(database)) {
+        isExist = getConnectionState(database).schemaCache.tables.contains(tableName.toLower());
+    }
+
+    return isExist;
 }
 
-QString SqliteManager::getColumnTypeName(const ColumnTypes &type) const
+QList<SqliteManager::ColumnDefinition> SqliteManager::getTableColumns(QSqlDatabase &database, const QString &tableName)
 {
-    QString name = "";
-    if (type == ColumnTypes::TEXT) {
-        name = "TEXT";
+    QList<ColumnDefinition> columns;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return columns;
     }
-    else if (type == ColumnTypes::PK_INTEGER) {
-        name = "INTEGER PRIMARY KEY";
+
+    // The cached columns are only trusted while the schema has not changed, a column may have been added from another connection.
+    if (refreshSchemaCache(database) == false) {
+        return columns;
     }
-    else if (type == ColumnTypes::PK_AUTOINCREMENT) {
-        name = "INTEGER PRIMARY KEY AUTOINCREMENT";
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", does not exist!");
+        return columns;
     }
-    else if (type == ColumnTypes::INTEGER) {
-        name = "INTEGER";
+
+    const QString key = tableName.toLower();
+    columns = getConnectionState(database).schemaCache.tables.value(key);
+    if (columns.size() > 0) {
+        return columns;
     }
-    else if (type == ColumnTypes::REAL) {
-        name = "REAL";
+
+    const QString sqlQueryStr = "PRAGMA table_info(\"" + tableName + "\")";
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (query.exec(sqlQueryStr) == false) {
+        updateError(query, sqlQueryStr);
+        LOG_ERROR("Error occurred. Message: " << query.lastError().text());
+        return columns;
     }
-    else if (type == ColumnTypes::BLOB) {
-        name = "BLOB";
+
+    // Columns of PRAGMA table_info: cid, name, type, notnull, dflt_value, pk
+    while (query.next()) {
+        const QString typeName = query.value(2).toString().toUpper();
+        const bool isPrimaryKey = query.value(5).toInt() > 0;
+        ColumnTypes type = getColumnType(typeName);
+        if (isPrimaryKey && type == ColumnTypes::INTEGER) {
+            type = ColumnTypes::PK_INTEGER;
+        }
+
+        columns.append(ColumnDefinition(query.value(3).toInt() == 0, type, query.value(1).toString()));
     }
-    else if (type == ColumnTypes::NULL_TYPE) {
-        name = "NULL";
+
+    query.finish();
+    SchemaCache &schemaCache = getConnectionState(database).schemaCache;
+    if (schemaCache.tables.contains(key)) {
+        schemaCache.tables[key] = columns;
     }
 
-    return name;
+    return columns;
 }
 
-SqliteManager::ColumnTypes SqliteManager::getColumnType(const QString &typeName) const
+void SqliteManager::invalidateSchemaCache(const QSqlDatabase &database)
 {
-    ColumnTypes type = ColumnTypes::NONE;
-    if (typeName == "TEXT") {
-        type = ColumnTypes::TEXT;
+    auto it = m_Connections.find(database.connectionName());
+    if (it != m_Connections.end()) {
+        it.value().schemaCache = SchemaCache();
     }
-    else if (typeName == "INTEGER PRIMARY KEY") {
-        type = ColumnTypes::PK_INTEGER;
+}
+
+void SqliteManager::setResultCacheCapacity(qint64 capacity)
+{
+    m_ResultCacheCapacity = qMax<qint64>(capacity, 0);
+    for (auto it = m_Connections.begin(); it != m_Connections.end(); it++) {
+        if (it.value().shared.isNull()) {
+            continue;
+        }
+
+        ResultCache &cache = it.value().shared->resultCache;
+        if (m_ResultCacheCapacity == 0) {
+            cache.clear();
+        }
+
+        while (cache.stats.size > m_ResultCacheCapacity && cache.usageOrder.size() > 0) {
+            cache.remove(cache.usageOrder.first());
+        }
     }
-    else if (typeName == "INTEGER PRIMARY KEY AUTOINCREMENT") {
-        type = ColumnTypes::PK_AUTOINCREMENT;
+}
+
+qint64 SqliteManager::getResultCacheCapacity() const
+{
+    return m_ResultCacheCapacity;
+}
+
+SqliteManager::ResultCacheStats SqliteManager::getResultCacheStats(const QSqlDatabase &database) const
+{
+    ResultCacheStats stats;
+    auto it = m_Connections.constFind(database.connectionName());
+    if (it != m_Connections.constEnd() && it.value().shared) {
+        const ResultCache &cache = it.value().shared->resultCache;
+        stats = cache.stats;
+        stats.entryCount = cache.entries.size();
     }
-    else if (typeName == "INTEGER") {
-        type = ColumnTypes::INTEGER;
+
+    return stats;
+}
+
+void SqliteManager::invalidateResultCache(const QSqlDatabase &database, const QString &tableName)
+{
+    // A manager that has not used the connection yet cannot have written to it either. The cache is shared, so the results cached by
+    // the other managers are dropped as well.
+    auto it = m_Connections.find(database.connectionName());
+    if (it == m_Connections.end() || it.value().shared.isNull()) {
+        return;
     }
-    else if (typeName == "REAL") {
-        type = ColumnTypes::REAL;
+
+    ResultCache &cache = it.value().shared->resultCache;
+    if (tableName.isEmpty()) {
+        cache.clear();
     }
-    else if (typeName == "BLOB") {
-        type = ColumnTypes::BLOB;
+    else {
+        cache.removeTable(tableName.toLower());
     }
-    else if (typeName == "NULL") {
-        type = ColumnTypes::NULL_TYPE;
+}
+
+bool SqliteManager::readResultCache(QSqlDatabase &database, const QByteArray &key, QList<QMap<QString, QVariant>> &rows)
+{
+    ConnectionState &state = getConnectionState(database);
+    if (state.shared.isNull()) {
+        return false;
     }
 
-    return type;
+    ResultCache &cache = state.shared->resultCache;
+    if (cache.entries.size() > 0 && state.shared->isDataVersionChecked == false) {
+        // Another connection may have changed any of the tables.
+        const qint64 dataVersion = executePragma(database, "data_version").toLongLong();
+        if (dataVersion != cache.dataVersion) {
+            cache.clear();
+        }
+
+        // Inside a transaction the other connections' commits are not visible until it ends. Within one pass of the event loop the
+        // lookups are close enough to share the check. Without either, every lookup checks it.
+        const bool isInEventLoop = QThread::currentThread()->loopLevel() > 0 && QAbstractEventDispatcher::instance();
+        if (state.shared->transactionDepth > 0 || isInEventLoop) {
+            state.shared->isDataVersionChecked = true;
+        }
+
+        if (isInEventLoop && static_cast<bool>(state.shared->eventLoopConnection) == false) {
+            QWeakPointer<SharedConnectionState> weakState = state.shared;
+            state.shared->eventLoopConnection = QObject::connect(QAbstractEventDispatcher::instance(),
+                                                                 &QAbstractEventDispatcher::aboutToBlock,
+                                                                 QAbstractEventDispatcher::instance(), [weakState]() {
+                QSharedPointer<SharedConnectionState> sharedState = weakState.toStrongRef();
+                if (sharedState && sharedState->transactionDepth == 0) {
+                    sharedState->isDataVersionChecked = false;
+                }
+            });
+        }
+    }
+
+    auto it = cache.entries.constFind(key);
+    if (it == cache.entries.constEnd()) {
+        cache.stats.misses++;
+        return false;
+    }
+
+    cache.stats.hits++;
+    cache.usageOrder.removeOne(key);
+    cache.usageOrder.append(key);
+    rows = it.value().rows;
+    return true;
 }
 
-void SqliteManager::updateError(QSqlDatabase &db, const QString &query)
+void SqliteManager::writeResultCache(QSqlDatabase &database, const QByteArray &key, const QString &tableName,
+                                     const QList<QMap<QString, QVariant>> &rows)
 {
-    m_LastError.error = db.lastError();
-    m_LastError.query = query;
+    ResultCacheEntry entry;
+    entry.rows = rows;
+    entry.tableName = tableName.toLower();
+    entry.size = key.size();
+    for (const QMap<QString, QVariant> &row : rows) {
+        // A rough estimate, the keys are shared between the rows but the map nodes are not.
+        entry.size += 64;
+        for (auto it = row.constBegin(); it != row.constEnd(); it++) {
+            entry.size += 48;
+            const QVariant &value = it.value();
+            if (value.type() == QVariant::String) {
+                entry.size += value.toString().size() * 2;
+            }
+            else if (value.type() == QVariant::ByteArray) {
+                entry.size += value.toByteArray().size();
+            }
+        }
+    }
+
+    if (entry.size > m_ResultCacheCapacity) {
+        return;
+    }
+
+    ConnectionState &state = getConnectionState(database);
+    if (state.shared.isNull()) {
+        return;
+    }
+
+    ResultCache &cache = state.shared->resultCache;
+    if (cache.entries.size() == 0) {
+        cache.dataVersion = executePragma(database, "data_version").toLongLong();
+    }
+
+#ifdef QUTILS_SQLITE_NATIVE
+    // Installed once per connection, the other managers use the same cache.
+    if (state.shared->isUpdateHookInstalled == false) {
+        sqlite3_update_hook(static_cast<sqlite3 *>(state.handle), &SqliteManager::onRowChanged, &cache);
+        state.shared->isUpdateHookInstalled = true;
+    }
+#endif // QUTILS_SQLITE_NATIVE
+
+    cache.remove(key);
+    while (cache.stats.size + entry.size > m_ResultCacheCapacity && cache.usageOrder.size() > 0) {
+        cache.remove(cache.usageOrder.first());
+    }
+
+    cache.stats.size += entry.size;
+    cache.entries.insert(key, entry);
+    cache.usageOrder.append(key);
+}
+
+void SqliteManager::onTableWritten(const QSqlDatabase &database, const QString &tableName)
+{
+#ifdef QUTILS_SQLITE_NATIVE
+    // The update hook takes care of the other tables changed by the triggers.
+    invalidateResultCache(database, tableName);
+#else
+    Q_UNUSED(tableName);
+    invalidateResultCache(database);
+#endif // QUTILS_SQLITE_NATIVE
+}
+
+void SqliteManager::onRowChanged(void *context, int operation, const char *databaseName, const char *tableName, long long rowID)
+{
+    Q_UNUSED(operation);
+    Q_UNUSED(databaseName);
+    Q_UNUSED(rowID);
+    static_cast<ResultCache *>(context)->removeTable(QString::fromUtf8(tableName).toLower());
+}
+
+QSharedPointer<SqliteManager::SharedConnectionState> SqliteManager::acquireSharedState(const QString &connectionName, void *handle)
+{
+    SharedConnectionRegistry &registry = getSharedConnectionRegistry();
+    // Declared before the locker, so If it turns out to be the last reference it is released after the mutex is unlocked.
+    QSharedPointer<SharedConnectionState> existing;
+    QMutexLocker locker(&registry.mutex);
+    existing = registry.states.value(connectionName).toStrongRef();
+    // A different handle means the connection was closed and opened again.
+    if (existing && existing->handle == handle) {
+        return existing;
+    }
+
+    QSharedPointer<SharedConnectionState> state(new SharedConnectionState(), &SqliteManager::releaseSharedState);
+    state->connectionName = connectionName;
+    state->handle = handle;
+    registry.states.insert(connectionName, state);
+    return state;
+}
+
+void SqliteManager::releaseSharedState(SharedConnectionState *state)
+{
+    SharedConnectionRegistry &registry = getSharedConnectionRegistry();
+    QSharedPointer<SharedConnectionState> current;
+    QMutexLocker locker(&registry.mutex);
+    current = registry.states.value(state->connectionName).toStrongRef();
+    if (current.isNull()) {
+        registry.states.remove(state->connectionName);
+    }
+
+#ifdef QUTILS_SQLITE_NATIVE
+    // The hook must not outlive the cache. If the connection was closed, the hook is gone with the handle. If it was opened again, the
+    // handle belongs to another state.
+    if (state->isUpdateHookInstalled && current.isNull() && QSqlDatabase::contains(state->connectionName)) {
+        const QSqlDatabase database = QSqlDatabase::database(state->connectionName, false);
+        if (getHandle(database) == state->handle) {
+            sqlite3_update_hook(static_cast<sqlite3 *>(state->handle), nullptr, nullptr);
+        }
+    }
+#endif // QUTILS_SQLITE_NATIVE
+
+    QObject::disconnect(state->eventLoopConnection);
+    delete state;
+}
+
+SqliteManager::SharedConnectionRegistry &SqliteManager::getSharedConnectionRegistry()
+{
+    // Never destroyed, the managers that are destroyed during the static destruction still release their states.
+    static SharedConnectionRegistry *registry = new SharedConnectionRegistry();
+    return *registry;
+}
+
+SqliteManager::StatementCache::StatementCache(const StatementCache &other)
+    : statements()
+    , usageOrder()
+    , stats()
+{
+    *this = other;
+}
+
+SqliteManager::StatementCache &SqliteManager::StatementCache::operator=(const StatementCache &other)
+{
+    if (this == &other) {
+        return *this;
+    }
+
+    statements = other.statements;
+    usageOrder = other.usageOrder;
+    stats = other.stats;
+    for (auto it = usageOrder.begin(); it != usageOrder.end(); it++) {
+        statements[*it].usageIt = it;
+    }
+
+    return *this;
+}
+
+void SqliteManager::StatementCache::insert(const QString &key, const QSqlQuery &query)
+{
+    StatementCacheEntry entry;
+    entry.query = query;
+    entry.usageIt = usageOrder.insert(usageOrder.end(), key);
+    statements.insert(key, entry);
+}
+
+void SqliteManager::StatementCache::markUsed(StatementCacheEntry &entry)
+{
+    usageOrder.splice(usageOrder.end(), usageOrder, entry.usageIt);
+}
+
+void SqliteManager::StatementCache::shrink(int capacity)
+{
+    while (static_cast<int>(usageOrder.size()) > capacity) {
+        statements.remove(usageOrder.front());
+        usageOrder.pop_front();
+        stats.evictions++;
+    }
+}
+
+void SqliteManager::StatementCache::clear()
+{
+    statements.clear();
+    usageOrder.clear();
+}
+
+void SqliteManager::ResultCache::remove(const QByteArray &key)
+{
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        stats.size -= it.value().size;
+        entries.erase(it);
+        usageOrder.removeOne(key);
+    }
+}
+
+void SqliteManager::ResultCache::removeTable(const QString &tableName)
+{
+    if (entries.size() == 0) {
+        return;
+    }
+
+    QList<QByteArray> keys;
+    for (auto it = entries.constBegin(); it != entries.constEnd(); it++) {
+        if (it.value().tableName == tableName) {
+            keys.append(it.key());
+        }
+    }
+
+    for (const QByteArray &key : keys) {
+        remove(key);
+    }
+
+    if (keys.size() > 0) {
+        stats.invalidations++;
+    }
+}
+
+void SqliteManager::ResultCache::clear()
+{
+    if (entries.size() > 0) {
+        stats.invalidations++;
+    }
+
+    entries.clear();
+    usageOrder.clear();
+    stats.size = 0;
+}
+
+bool SqliteManager::dropTable(QSqlDatabase &database, const QString &tableName)
+{
+    bool successful = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return successful;
+    }
+
+    if (isTableExist(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", does not exist!");
+        return successful;
+    }
+
+    onTableWritten(database, tableName);
+    const QString sqlQueryStr = "DROP TABLE " + tableName;
+    QSqlQuery query(database);
+    bool successfull = query.exec(sqlQueryStr);
+    if (successfull == false) {
+        updateError(database, sqlQueryStr);
+        LOG_ERROR("Error occurred. Message: " << database.lastError().text());
+    }
+    else {
+        updateSchemaCache(database, tableName, QList<ColumnDefinition>(), true);
+        successful = true;
+    }
+
+    return successful;
+}
+
+bool SqliteManager::createIndex(QSqlDatabase &database, const IndexDefinition &index, bool ifNotExists)
+{
+    bool successful = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return successful;
+    }
+
+    if (index.name.isEmpty() || index.columns.size() == 0) {
+        LOG_ERROR("Index name and columns cannot be empty!");
+        return successful;
+    }
+
+    QString sqlQueryStr = QString("CREATE ") + (index.isUnique ? "UNIQUE " : "") + "INDEX " + (ifNotExists ? "IF NOT EXISTS " : "");
+    sqlQueryStr += Where::quoteIdentifier(index.name) + " ON " + Where::quoteIdentifier(index.tableName);
+    sqlQueryStr += " (" + index.columns.join(", ") + ")";
+    if (index.whereClause.isEmpty() == false) {
+        sqlQueryStr += " WHERE " + index.whereClause;
+    }
+
+    QSqlQuery query(database);
+    successful = query.exec(sqlQueryStr);
+    if (successful == false) {
+        updateError(query, sqlQueryStr);
+        LOG_ERROR("Error occurred. Message: " << query.lastError().text() << ". Query: " << sqlQueryStr);
+    }
+
+    return successful;
+}
+
+bool SqliteManager::dropIndex(QSqlDatabase &database, const QString &indexName, bool ifExists)
+{
+    bool successful = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return successful;
+    }
+
+    const QString sqlQueryStr = QString("DROP INDEX ") + (ifExists ? "IF EXISTS " : "") + Where::quoteIdentifier(indexName);
+    QSqlQuery query(database);
+    successful = query.exec(sqlQueryStr);
+    if (successful == false) {
+        updateError(query, sqlQueryStr);
+        LOG_ERROR("Error occurred. Message: " << query.lastError().text() << ". Query: " << sqlQueryStr);
+    }
+
+    return successful;
+}
+
+bool SqliteManager::hasIndex(QSqlDatabase &database, const QString &indexName)
+{
+    bool exists = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return exists;
+    }
+
+    forEachRow(database, "SELECT 1 FROM sqlite_master WHERE type = 'index' AND name = ?", [&exists](const Cursor &) {
+        exists = true;
+        return false;
+    }, {indexName});
+
+    return exists;
+}
+
+SqliteManager::QueryPlan SqliteManager::explainQueryPlan(QSqlDatabase &database, const QString &sqlQueryStr, const QVariantList &bindValues)
+{
+    QueryPlan plan;
+    // Columns of EXPLAIN QUERY PLAN: id, parent, notused, detail
+    QHash<int, int> depths;
+    forEachRow(database, "EXPLAIN QUERY PLAN " + sqlQueryStr, [&plan, &depths](const Cursor &cursor) {
+        QueryPlanStep step;
+        step.id = cursor.value(0).toInt();
+        step.parentID = cursor.value(1).toInt();
+        step.depth = depths.contains(step.parentID) ? depths.value(step.parentID) + 1 : 0;
+        step.detail = cursor.value(3).toString();
+        depths.insert(step.id, step.depth);
+        plan.steps.append(step);
+        return true;
+    }, bindValues);
+
+    return plan;
+}
+
+bool SqliteManager::createFullTextTable(QSqlDatabase &database, const FullTextTableDefinition &definition)
+{
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return false;
+    }
+
+    if (definition.name.isEmpty() || definition.columns.size() == 0) {
+        LOG_ERROR("Full-text table name and columns cannot be empty!");
+        return false;
+    }
+
+    const bool isExternalContent = definition.contentTableName.isEmpty() == false;
+    const QString tableName = Where::quoteIdentifier(definition.name);
+    QStringList arguments, columns, newValues, oldValues;
+    for (const QString &column : definition.columns) {
+        const QString quotedColumn = Where::quoteIdentifier(column);
+        arguments.append(quotedColumn);
+        columns.append(quotedColumn);
+        newValues.append("new." + quotedColumn);
+        oldValues.append("old." + quotedColumn);
+    }
+
+    auto toLiteral = [](QString value) {
+        return "'" + value.replace("'", "''") + "'";
+    };
+
+    if (isExternalContent) {
+        arguments.append("content=" + toLiteral(definition.contentTableName));
+        arguments.append("content_rowid=" + toLiteral(definition.contentRowIDColumn));
+    }
+
+    if (definition.tokenizer.isEmpty() == false) {
+        arguments.append("tokenize=" + toLiteral(definition.tokenizer));
+    }
+
+    QStringList statements {
+        "CREATE VIRTUAL TABLE " + tableName + " USING fts5(" + arguments.join(", ") + ")"
+    };
+
+    if (isExternalContent) {
+        const QString contentTableName = Where::quoteIdentifier(definition.contentTableName);
+        const QString rowIDColumn = Where::quoteIdentifier(definition.contentRowIDColumn);
+        const QString insertStatement = "INSERT INTO " + tableName + "(rowid, " + columns.join(", ") + ") VALUES(new." + rowIDColumn +
+                                        ", " + newValues.join(", ") + ");";
+        const QString deleteStatement = "INSERT INTO " + tableName + "(" + tableName + ", rowid, " + columns.join(", ") +
+                                        ") VALUES('delete', old." + rowIDColumn + ", " + oldValues.join(", ") + ");";
+
+        statements.append("CREATE TRIGGER " + Where::quoteIdentifier(definition.name + "_ai") + " AFTER INSERT ON " + contentTableName +
+                          " BEGIN " + insertStatement + " END");
+        statements.append("CREATE TRIGGER " + Where::quoteIdentifier(definition.name + "_ad") + " AFTER DELETE ON " + contentTableName +
+                          " BEGIN " + deleteStatement + " END");
+        statements.append("CREATE TRIGGER " + Where::quoteIdentifier(definition.name + "_au") + " AFTER UPDATE ON " + contentTableName +
+                          " BEGIN " + deleteStatement + " " + insertStatement + " END");
+        // Index the rows that are already in the content table.
+        statements.append("INSERT INTO " + tableName + "(" + tableName + ") VALUES('rebuild')");
+    }
+
+    Transaction transaction(*this, database);
+    if (transaction.isActive() == false) {
+        return false;
+    }
+
+    for (const QString &statement : statements) {
+        if (executeQuery(database, statement) == false) {
+            return false;
+        }
+    }
+
+    return transaction.commit();
+}
+
+bool SqliteManager::dropFullTextTable(QSqlDatabase &database, const FullTextTableDefinition &definition)
+{
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return false;
+    }
+
+    Transaction transaction(*this, database);
+    if (transaction.isActive() == false) {
+        return false;
+    }
+
+    if (definition.contentTableName.isEmpty() == false) {
+        for (const QString &suffix : QStringList{"_ai", "_ad", "_au"}) {
+            if (executeQuery(database, "DROP TRIGGER IF EXISTS " + Where::quoteIdentifier(definition.name + suffix)) == false) {
+                return false;
+            }
+        }
+    }
+
+    if (executeQuery(database, "DROP TABLE IF EXISTS " + Where::quoteIdentifier(definition.name)) == false) {
+        return false;
+    }
+
+    return transaction.commit();
+}
+
+bool SqliteManager::rebuildFullTextTable(QSqlDatabase &database, const QString &tableName)
+{
+    const QString quotedTableName = Where::quoteIdentifier(tableName);
+    return executeQuery(database, "INSERT INTO " + quotedTableName + "(" + quotedTableName + ") VALUES('rebuild')");
+}
+
+bool SqliteManager::optimizeFullTextTable(QSqlDatabase &database, const QString &tableName)
+{
+    const QString quotedTableName = Where::quoteIdentifier(tableName);
+    return executeQuery(database, "INSERT INTO " + quotedTableName + "(" + quotedTableName + ") VALUES('optimize')");
+}
+
+QList<SqliteManager::SearchHit> SqliteManager::search(QSqlDatabase &database, const QString &tableName, const QString &query, int limit,
+        const SearchOptions &options)
+{
+    QList<SearchHit> hits;
+    if (query.trimmed().isEmpty()) {
+        return hits;
+    }
+
+    // rank is the hidden column of FTS5 that holds the bm25 score, ordering by it lets FTS5 sort the hits itself.
+    const QString quotedTableName = Where::quoteIdentifier(tableName);
+    const QString sqlQueryStr = "SELECT rowid, rank, snippet(" + quotedTableName + ", ?, ?, ?, ?, ?), * FROM " + quotedTableName +
+                                " WHERE " + quotedTableName + " MATCH ? ORDER BY rank LIMIT ? OFFSET ?";
+    const QVariantList bindValues {
+        options.snippetColumn, options.highlightStart, options.highlightEnd, options.ellipsis, qBound(1, options.snippetTokenCount, 64),
+        query, limit, options.offset
+    };
+
+    Cursor cursor = openCursor(database, sqlQueryStr, bindValues);
+    const QStringList columnNames = cursor.getColumnNames();
+    while (cursor.next()) {
+        SearchHit hit;
+        hit.rowID = cursor.value(0).toLongLong();
+        hit.rank = cursor.value(1).toDouble();
+        hit.snippet = cursor.value(2).toString();
+        for (int columnIndex = 3; columnIndex < columnNames.size(); columnIndex++) {
+            hit.columns[columnNames.at(columnIndex)] = cursor.value(columnIndex);
+        }
+
+        hits.append(hit);
+    }
+
+    return hits;
+}
+
+QString SqliteManager::toFullTextQuery(const QString &text, bool isPrefixMatch)
+{
+    QStringList terms = text.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    for (QString &term : terms) {
+        term = "\"" + term.replace("\"", "\"\"") + "\"";
+    }
+
+    if (isPrefixMatch && terms.size() > 0) {
+        terms.last() += "*";
+    }
+
+    return terms.join(' ');
+}
+
+QString SqliteManager::constructWhereQuery(const QList<SqliteManager::Constraint> &values)
+{
+    QString query = "WHERE ";
+    int index = 0;
+    for (const auto &t : values) {
+        if (index != 0) {
+            query += " ";
+        }
+
+        query += std::get<0>(t) + "='" + std::get<1>(t) + "'";
+        if (index < values.size() - 1) {
+            query += " " + std::get<2>(t);
+        }
+
+        index++;
+    }
+
+    return query;
+}
+
+bool SqliteManager::executeQuery(QSqlDatabase &database, const QString &sqlQueryStr, const QVariantList &bindValues, int *rowsChanged)
+{
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return false;
+    }
+
+    QSqlQuery query;
+    if (prepareQuery(database, sqlQueryStr, query) == false) {
+        return false;
+    }
+
+    bindQueryValues(query, bindValues);
+    const bool successful = execQuery(query, sqlQueryStr);
+    if (successful && rowsChanged) {
+        *rowsChanged = query.numRowsAffected();
+    }
+
+    const bool isSelect = query.isSelect();
+    query.finish();
+    const QString statement = sqlQueryStr.simplified().section(' ', 0, 0).toUpper();
+    if (statement == "CREATE" || statement == "ALTER" || statement == "DROP") {
+        invalidateSchemaCache(database);
+    }
+
+    // The tables the statement has changed are not known. A failed statement has not changed anything.
+    if (successful && isSelect == false && statement != "PRAGMA") {
+        invalidateResultCache(database);
+    }
+
+    return successful;
+}
+
+QList<QMap<QString, QVariant> > SqliteManager::executeSelectQuery(QSqlDatabase &database, const QString &sqlQueryStr)
+{
+    QList<QMap<QString, QVariant>> resultList;
+    forEachRow(database, sqlQueryStr, [&resultList](const Cursor &cursor) {
+        resultList.append(cursor.getRow());
+        return true;
+    });
+
+    return resultList;
+}
+
+bool SqliteManager::executeSelectQuery(QSqlDatabase &database, const QString &sqlQueryStr, ResultSet &resultSet,
+                                       const QVariantList &bindValues)
+{
+    resultSet.clear();
+    Cursor cursor = openCursor(database, sqlQueryStr, bindValues);
+    if (cursor.isValid() == false) {
+        return false;
+    }
+
+    resultSet.setColumnNames(cursor.getColumnNames());
+    while (cursor.next()) {
+        resultSet.appendRow(cursor.m_Query);
+    }
+
+    return true;
+}
+
+SqliteManager::Cursor SqliteManager::openCursor(QSqlDatabase &database, const QString &sqlQueryStr, const QVariantList &bindValues)
+{
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return Cursor();
+    }
+
+    QSqlQuery query;
+    if (prepareQuery(database, sqlQueryStr, query) == false) {
+        return Cursor();
+    }
+
+    bindQueryValues(query, bindValues);
+    if (execQuery(query, sqlQueryStr) == false) {
+        return Cursor();
+    }
+
+    return Cursor(query, m_IsQueryStatsEnabled ? this : nullptr, sqlQueryStr);
+}
+
+bool SqliteManager::forEachRow(QSqlDatabase &database, const QString &sqlQueryStr, const RowCallback &callback, const QVariantList &bindValues)
+{
+    Cursor cursor = openCursor(database, sqlQueryStr, bindValues);
+    if (cursor.isValid() == false) {
+        return false;
+    }
+
+    while (cursor.next()) {
+        if (callback(cursor) == false) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+QList<QMap<QString, QVariant> > SqliteManager::getFromTable(QSqlDatabase &database, const QString &tableName, const unsigned int &limit,
+        const QList<Constraint> *constraints, const SelectOrder *selectOrder)
+{
+    return getFromTable(database, tableName, constraints ? toWhere(*constraints) : Where(), limit, selectOrder);
+}
+
+bool SqliteManager::getFromTable(QSqlDatabase &database, const QString &tableName, ResultSet &resultSet, const unsigned int &limit,
+                                 const QList<Constraint> *constraints, const SelectOrder *selectOrder)
+{
+    return getFromTable(database, tableName, resultSet, constraints ? toWhere(*constraints) : Where(), limit, selectOrder);
+}
+
+QList<QMap<QString, QVariant>> SqliteManager::getFromTable(QSqlDatabase &database, const QString &tableName, const Where &where,
+        const unsigned int &limit, const SelectOrder *selectOrder)
+{
+    return getFromTable(database, tableName, QStringList(), where, limit, selectOrder);
+}
+
+bool SqliteManager::getFromTable(QSqlDatabase &database, const QString &tableName, ResultSet &resultSet, const Where &where,
+                                 const unsigned int &limit, const SelectOrder *selectOrder)
+{
+    return getFromTable(database, tableName, resultSet, QStringList(), where, limit, selectOrder);
+}
+
+QList<QMap<QString, QVariant>> SqliteManager::getFromTable(QSqlDatabase &database, const QString &tableName, const QStringList &columns,
+        const Where &where, const unsigned int &limit, const SelectOrder *selectOrder)
+{
+    QList<QMap<QString, QVariant>> resultList;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return resultList;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return resultList;
+    }
+
+    QVariantList values;
+    const QString sqlQueryStr = constructSelectQuery(tableName, columns, limit, where, selectOrder, values);
+    QByteArray cacheKey;
+    if (m_ResultCacheCapacity > 0) {
+        QDataStream stream(&cacheKey, QIODevice::WriteOnly);
+        stream << sqlQueryStr << values;
+        if (readResultCache(database, cacheKey, resultList)) {
+            return resultList;
+        }
+    }
+
+    const bool successful = forEachRow(database, sqlQueryStr, [&resultList](const Cursor &cursor) {
+        resultList.append(cursor.getRow());
+        return true;
+    }, values);
+
+    if (successful && m_ResultCacheCapacity > 0) {
+        writeResultCache(database, cacheKey, tableName, resultList);
+    }
+
+    return resultList;
+}
+
+bool SqliteManager::getFromTable(QSqlDatabase &database, const QString &tableName, ResultSet &resultSet, const QStringList &columns,
+                                 const Where &where, const unsigned int &limit, const SelectOrder *selectOrder)
+{
+    resultSet.clear();
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return false;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return false;
+    }
+
+    QVariantList values;
+    const QString sqlQueryStr = constructSelectQuery(tableName, columns, limit, where, selectOrder, values);
+    return executeSelectQuery(database, sqlQueryStr, resultSet, values);
+}
+
+QList<QMap<QString, QVariant>> SqliteManager::aggregate(QSqlDatabase &database, const QString &tableName,
+        const QList<Aggregate> &aggregates, const QStringList &groupBy, const Where &where, const Where &having,
+        const SelectOrder *selectOrder, const unsigned int &limit)
+{
+    QList<QMap<QString, QVariant>> resultList;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return resultList;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return resultList;
+    }
+
+    if (aggregates.isEmpty() && groupBy.isEmpty()) {
+        LOG_ERROR("At least one aggregate or group column is required!");
+        return resultList;
+    }
+
+    QStringList groupColumns, selectColumns;
+    for (const QString &column : groupBy) {
+        groupColumns.append(Where::quoteIdentifier(column));
+    }
+
+    selectColumns = groupColumns;
+    for (const Aggregate &aggregate : aggregates) {
+        QString argument = "*";
+        if (aggregate.column.isEmpty() == false) {
+            argument = (aggregate.isDistinct ? "DISTINCT " : "") + Where::quoteIdentifier(aggregate.column);
+        }
+        else if (aggregate.function != AggregateFunction::COUNT) {
+            LOG_ERROR("Only COUNT can be used without a column!");
+            return resultList;
+        }
+
+        selectColumns.append(aggregate.getFunctionName() + "(" + argument + ") AS " + Where::quoteIdentifier(aggregate.getAlias()));
+    }
+
+    QString sqlQueryStr = "SELECT " + selectColumns.join(',') + " FROM " + tableName;
+    QVariantList values = where.getBindValues();
+    if (where.isEmpty() == false) {
+        sqlQueryStr += " " + where.getQuery();
+    }
+
+    if (groupColumns.isEmpty() == false) {
+        sqlQueryStr += " GROUP BY " + groupColumns.join(',');
+    }
+
+    if (having.isEmpty() == false) {
+        sqlQueryStr += " HAVING " + having.getConditions();
+        values.append(having.getBindValues());
+    }
+
+    if (selectOrder && selectOrder->fieldName.length() > 0) {
+        const QString orderType = selectOrder->order == SelectOrder::OrderType::ASC ? "ASC" : "DESC";
+        sqlQueryStr += " ORDER BY " + selectOrder->fieldName + " " + orderType;
+    }
+
+    if (limit > 0) {
+        sqlQueryStr += " LIMIT ?";
+        values.append(limit);
+    }
+
+    forEachRow(database, sqlQueryStr, [&resultList](const Cursor &cursor) {
+        resultList.append(cursor.getRow());
+        return true;
+    }, values);
+
+    return resultList;
+}
+
+QVariant SqliteManager::aggregateValue(QSqlDatabase &database, const QString &tableName, AggregateFunction function,
+                                       const QString &column, const Where &where, bool isDistinct)
+{
+    const Aggregate value(function, column, "value", isDistinct);
+    const QList<QMap<QString, QVariant>> rows = aggregate(database, tableName, {value}, QStringList(), where);
+    return rows.isEmpty() ? QVariant() : rows.first().value("value");
+}
+
+qint64 SqliteManager::count(QSqlDatabase &database, const QString &tableName, const Where &where)
+{
+    const QVariant value = aggregateValue(database, tableName, AggregateFunction::COUNT, QString(), where);
+    return value.isValid() ? value.toLongLong() : -1;
+}
+
+SqliteManager::Page SqliteManager::getPageFromTable(QSqlDatabase &database, const QString &tableName, const QStringList &sortColumns,
+        int pageSize, const QString &continuationToken, const Where &where, SelectOrder::OrderType order)
+{
+    Page page;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return page;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return page;
+    }
+
+    if (sortColumns.size() == 0 || pageSize <= 0) {
+        LOG_ERROR("Sort columns cannot be empty and the page size must be positive!");
+        return page;
+    }
+
+    QStringList tokenColumns;
+    QVariantList lastKey;
+    if (continuationToken.isEmpty() == false) {
+        QDataStream stream(QByteArray::fromBase64(continuationToken.toLatin1(), QByteArray::Base64UrlEncoding));
+        stream >> tokenColumns >> lastKey;
+        if (stream.status() != QDataStream::Ok || tokenColumns != sortColumns || lastKey.size() != sortColumns.size()) {
+            LOG_ERROR("Continuation token does not belong to the sort columns " << sortColumns);
+            return page;
+        }
+    }
+
+    QStringList quotedColumns, keyPlaceholders, orderTerms;
+    const QString orderType = order == SelectOrder::OrderType::ASC ? "ASC" : "DESC";
+    for (const QString &column : sortColumns) {
+        quotedColumns.append(Where::quoteIdentifier(column));
+        keyPlaceholders.append("?");
+        orderTerms.append(Where::quoteIdentifier(column) + " " + orderType);
+    }
+
+    // The sort key is selected after the table columns so it can be read by index, even for columns that * does not return (e.g rowid).
+    QString sqlQueryStr = "SELECT *, " + quotedColumns.join(", ") + " FROM " + tableName;
+    QStringList conditions;
+    QVariantList values;
+    if (where.isEmpty() == false) {
+        conditions.append("(" + where.getConditions() + ")");
+        values.append(where.getBindValues());
+    }
+
+    if (lastKey.size() > 0) {
+        const QString comparison = order == SelectOrder::OrderType::ASC ? " > " : " < ";
+        conditions.append("(" + quotedColumns.join(", ") + ")" + comparison + "(" + keyPlaceholders.join(", ") + ")");
+        values.append(lastKey);
+    }
+
+    if (conditions.size() > 0) {
+        sqlQueryStr += " WHERE " + conditions.join(" AND ");
+    }
+
+    // One more row is fetched to find out If there's a next page.
+    sqlQueryStr += " ORDER BY " + orderTerms.join(", ") + " LIMIT ?";
+    values.append(pageSize + 1);
+
+    QVariantList rowKey;
+    const bool successful = forEachRow(database, sqlQueryStr, [&page, &rowKey, &sortColumns, pageSize](const Cursor &cursor) {
+        if (page.rows.size() == pageSize) {
+            page.hasMore = true;
+            return false;
+        }
+
+        const int tableColumnCount = cursor.getColumnCount() - sortColumns.size();
+        QMap<QString, QVariant> row;
+        for (int columnIndex = 0; columnIndex < tableColumnCount; columnIndex++) {
+            row[cursor.m_Record.fieldName(columnIndex)] = cursor.value(columnIndex);
+        }
+
+        rowKey.clear();
+        for (int keyIndex = 0; keyIndex < sortColumns.size(); keyIndex++) {
+            rowKey.append(cursor.value(tableColumnCount + keyIndex));
+        }
+
+        page.rows.append(row);
+        return true;
+    }, values);
+
+    if (successful && page.hasMore) {
+        QByteArray tokenData;
+        QDataStream stream(&tokenData, QIODevice::WriteOnly);
+        stream << sortColumns << rowKey;
+        page.continuationToken = QString::fromLatin1(tokenData.toBase64(QByteArray::Base64UrlEncoding));
+    }
+
+    return page;
+}
+
+bool SqliteManager::insertIntoTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row)
+{
+    bool successful = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return successful;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return successful;
+    }
+
+    QString sqlQueryStr = "INSERT INTO " + tableName + " ";
+    QStringList columnNames, valuePlaceholders;
+    for (auto it = row.constBegin(); it != row.constEnd(); it++) {
+        columnNames.append(it.key());
+        valuePlaceholders.append(":" + it.key());
+    }
+
+    sqlQueryStr.append("(" + columnNames.join(',') + ") ");
+    sqlQueryStr.append("VALUES(" + valuePlaceholders.join(',') + ")");
+
+    QSqlQuery query;
+    if (prepareQuery(database, sqlQueryStr, query) == false) {
+        return successful;
+    }
+
+    // Now bind the values
+    for (auto it = row.constBegin(); it != row.constEnd(); it++) {
+        query.bindValue(":" + it.key(), it.value());
+    }
+
+    successful = execQuery(query, sqlQueryStr);
+    query.finish();
+    onTableWritten(database, tableName);
+
+    return successful;
+}
+
+SqliteManager::BatchResult SqliteManager::insertManyIntoTable(QSqlDatabase &database, const QString &tableName,
+        const QList<QMap<QString, QVariant>> &rows)
+{
+    BatchResult result;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return result;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return result;
+    }
+
+    // If there's already an active transaction, the rows become a part of it.
+    Transaction transaction(*this, database);
+    if (transaction.isActive() == false) {
+        return result;
+    }
+
+    QSqlQuery query;
+    QStringList columnNames;
+    QString sqlQueryStr;
+    bool isPrepared = false;
+    for (int rowIndex = 0; rowIndex < rows.size(); rowIndex++) {
+        const QMap<QString, QVariant> &row = rows.at(rowIndex);
+        // Rows are usually of the same shape, so only prepare again when the columns change.
+        if (isPrepared == false || row.keys() != columnNames) {
+            columnNames = row.keys();
+            sqlQueryStr = constructInsertQuery(tableName, columnNames);
+            isPrepared = prepareQuery(database, sqlQueryStr, query);
+            if (isPrepared == false) {
+                result.failedRows.insert(rowIndex, m_LastError.error);
+                continue;
+            }
+        }
+
+        int valueIndex = 0;
+        for (auto it = row.constBegin(); it != row.constEnd(); it++) {
+            query.bindValue(valueIndex, it.value());
+            valueIndex++;
+        }
+
+        if (execQuery(query, sqlQueryStr)) {
+            result.insertedCount++;
+        }
+        else {
+            result.failedRows.insert(rowIndex, query.lastError());
+        }
+    }
+
+    if (isPrepared) {
+        query.finish();
+    }
+
+    onTableWritten(database, tableName);
+    result.isCommitted = transaction.commit();
+    if (result.isCommitted == false) {
+        LOG_ERROR("Cannot commit the batch. Message: " << m_LastError.error.text());
+        result.insertedCount = 0;
+    }
+
+    return result;
+}
+
+SqliteManager::BatchResult SqliteManager::insertManyIntoTable(QSqlDatabase &database, const QString &tableName,
+        const QStringList &columnNames, const QList<QVariantList> &columnValues)
+{
+    BatchResult result;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return result;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return result;
+    }
+
+    if (columnNames.size() == 0 || columnNames.size() != columnValues.size()) {
+        LOG_ERROR("There must be one value list for each column!");
+        return result;
+    }
+
+    const int rowCount = columnValues.at(0).size();
+    for (const QVariantList &values : columnValues) {
+        if (values.size() != rowCount) {
+            LOG_ERROR("All of the value lists must have the same size!");
+            return result;
+        }
+    }
+
+    const QString sqlQueryStr = constructInsertQuery(tableName, columnNames);
+    QSqlQuery query;
+    if (prepareQuery(database, sqlQueryStr, query) == false) {
+        return result;
+    }
+
+    Transaction transaction(*this, database);
+    if (transaction.isActive() == false) {
+        query.finish();
+        return result;
+    }
+
+    for (int rowIndex = 0; rowIndex < rowCount; rowIndex++) {
+        for (int columnIndex = 0; columnIndex < columnNames.size(); columnIndex++) {
+            query.bindValue(columnIndex, columnValues.at(columnIndex).at(rowIndex));
+        }
+
+        if (execQuery(query, sqlQueryStr)) {
+            result.insertedCount++;
+        }
+        else {
+            result.failedRows.insert(rowIndex, query.lastError());
+        }
+    }
+
+    query.finish();
+    onTableWritten(database, tableName);
+    result.isCommitted = transaction.commit();
+    if (result.isCommitted == false) {
+        LOG_ERROR("Cannot commit the batch. Message: " << m_LastError.error.text());
+        result.insertedCount = 0;
+    }
+
+    return result;
+}
+
+SqliteManager::ImportResult SqliteManager::importFrom(QSqlDatabase &database, QIODevice *device, DataFormat format,
+        const QString &tableName, const QMap<QString, QString> &columnMapping, const ImportOptions &options)
+{
+    ImportResult result;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return result;
+    }
+
+    if (device == nullptr || device->isReadable() == false) {
+        LOG_ERROR("Given device is not open for reading!");
+        return result;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int batchSize = qMax(options.batchSize, 1);
+    QList<QMap<QString, QVariant>> batch;
+    // Index of the record in the input for every row in the batch.
+    QList<qint64> batchRecordIndexes;
+    batch.reserve(batchSize);
+    batchRecordIndexes.reserve(batchSize);
+
+    auto addRow = [&columnMapping, &batch, &batchRecordIndexes](const QMap<QString, QVariant> &inputRow, qint64 recordIndex) {
+        if (columnMapping.size() == 0) {
+            batch.append(inputRow);
+        }
+        else {
+            QMap<QString, QVariant> row;
+            for (auto it = inputRow.constBegin(); it != inputRow.constEnd(); it++) {
+                if (columnMapping.contains(it.key())) {
+                    row[columnMapping.value(it.key())] = it.value();
+                }
+            }
+
+            batch.append(row);
+        }
+
+        batchRecordIndexes.append(recordIndex);
+    };
+
+    auto flushBatch = [&]() -> bool {
+        if (batch.size() == 0) {
+            return true;
+        }
+
+        const BatchResult batchResult = insertManyIntoTable(database, tableName, batch);
+        for (auto it = batchResult.failedRows.constBegin(); it != batchResult.failedRows.constEnd(); it++) {
+            result.failedRows.insert(batchRecordIndexes.at(it.key()), it.value());
+        }
+
+        const qint64 firstRecordIndex = batchRecordIndexes.first();
+        batch.clear();
+        batchRecordIndexes.clear();
+        result.elapsed = timer.elapsed();
+        if (batchResult.isCommitted == false) {
+            if (batchResult.failedRows.size() == 0) {
+                result.failedRows.insert(firstRecordIndex, m_LastError.error);
+            }
+
+            return false;
+        }
+
+        result.insertedCount += batchResult.insertedCount;
+        if (options.progressCallback && options.progressCallback(result) == false) {
+            result.isCancelled = true;
+            return false;
+        }
+
+        return true;
+    };
+
+    bool isStopped = false;
+    if (format == DataFormat::CSV) {
+        QStringList columnNames = options.csvColumnNames;
+        QStringList fields;
+        while (isStopped == false && readCsvRecord(device, options.csvDelimiter, fields, result.bytesRead, options.readTimeout)) {
+            // Skip the empty lines.
+            if (fields.size() == 1 && fields.first().isEmpty()) {
+                continue;
+            }
+
+            if (columnNames.size() == 0) {
+                columnNames = fields;
+                // Excel writes a byte order mark at the start of the file.
+                columnNames[0].remove(QChar(0xFEFF));
+                continue;
+            }
+
+            const qint64 recordIndex = result.readCount++;
+            if (fields.size() != columnNames.size()) {
+                result.failedRows.insert(recordIndex, QSqlError(QString(), QString("Expected %1 fields but found %2.")
+                                         .arg(columnNames.size()).arg(fields.size()), QSqlError::UnknownError));
+                continue;
+            }
+
+            QMap<QString, QVariant> row;
+            for (int fieldIndex = 0; fieldIndex < fields.size(); fieldIndex++) {
+                row[columnNames.at(fieldIndex)] = fields.at(fieldIndex);
+            }
+
+            addRow(row, recordIndex);
+            if (batch.size() >= batchSize) {
+                isStopped = flushBatch() == false;
+            }
+        }
+    }
+    else {
+        while (isStopped == false) {
+            const QByteArray line = readDeviceLine(device, options.readTimeout);
+            if (line.isEmpty()) {
+                break;
+            }
+
+            result.bytesRead += line.size();
+            if (line.trimmed().isEmpty()) {
+                continue;
+            }
+
+            const qint64 recordIndex = result.readCount++;
+            QJsonParseError parseError;
+            const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+            if (parseError.error != QJsonParseError::NoError || document.isObject() == false) {
+                const QString message = parseError.error != QJsonParseError::NoError ? parseError.errorString() : "Line is not a JSON object.";
+                result.failedRows.insert(recordIndex, QSqlError(QString(), message, QSqlError::UnknownError));
+                continue;
+            }
+
+            const QJsonObject object = document.object();
+            QMap<QString, QVariant> row;
+            for (auto it = object.constBegin(); it != object.constEnd(); it++) {
+                const QJsonValue value = it.value();
+                if (value.isObject()) {
+                    row[it.key()] = QString::fromUtf8(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+                }
+                else if (value.isArray()) {
+                    row[it.key()] = QString::fromUtf8(QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact));
+                }
+                else {
+                    row[it.key()] = value.toVariant();
+                }
+            }
+
+            addRow(row, recordIndex);
+            if (batch.size() >= batchSize) {
+                isStopped = flushBatch() == false;
+            }
+        }
+    }
+
+    if (isStopped == false) {
+        result.isCompleted = flushBatch();
+    }
+
+    result.elapsed = timer.elapsed();
+    return result;
+}
+
+bool SqliteManager::exportTo(QSqlDatabase &database, QIODevice *device, DataFormat format, const QString &sqlQueryStr,
+                             const QVariantList &bindValues, const ExportOptions &options, qint64 *exportedCount)
+{
+    if (exportedCount) {
+        *exportedCount = 0;
+    }
+
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return false;
+    }
+
+    if (device == nullptr || device->isWritable() == false) {
+        LOG_ERROR("Given device is not open for writing!");
+        return false;
+    }
+
+    QIODevice *output = device;
+#ifdef QUTILS_ZLIB
+    QScopedPointer<GzipDevice> gzipDevice;
+    if (options.isGzipEnabled) {
+        gzipDevice.reset(new GzipDevice(device));
+        if (gzipDevice->open(QIODevice::WriteOnly) == false) {
+            return false;
+        }
+
+        output = gzipDevice.data();
+    }
+#else
+    if (options.isGzipEnabled) {
+        LOG_ERROR("qutils is built without zlib, gzip compression is not available!");
+        return false;
+    }
+#endif // QUTILS_ZLIB
+
+    Cursor cursor = openCursor(database, sqlQueryStr, bindValues);
+    if (cursor.isValid() == false) {
+        return false;
+    }
+
+    const QStringList columnNames = cursor.getColumnNames();
+    const int columnCount = columnNames.size();
+    bool successful = true;
+    if (format == DataFormat::CSV && options.hasCsvHeader) {
+        QStringList fields;
+        for (const QString &columnName : columnNames) {
+            fields.append(escapeCsvField(columnName, options.csvDelimiter));
+        }
+
+        successful = output->write(QString(fields.join(options.csvDelimiter) + "\r\n").toUtf8()) != -1;
+    }
+
+    qint64 rowCount = 0;
+    while (successful && cursor.next()) {
+        QByteArray line;
+        if (format == DataFormat::CSV) {
+            QStringList fields;
+            for (int columnIndex = 0; columnIndex < columnCount; columnIndex++) {
+                const QVariant value = cursor.value(columnIndex);
+                const QString field = value.type() == QVariant::ByteArray ? QString::fromLatin1(value.toByteArray().toBase64()) :
+                                      value.toString();
+                fields.append(escapeCsvField(field, options.csvDelimiter));
+            }
+
+            line = QString(fields.join(options.csvDelimiter) + "\r\n").toUtf8();
+        }
+        else {
+            QJsonObject object;
+            for (int columnIndex = 0; columnIndex < columnCount; columnIndex++) {
+                const QVariant value = cursor.value(columnIndex);
+                if (value.isNull()) {
+                    object.insert(columnNames.at(columnIndex), QJsonValue::Null);
+                }
+                else if (value.type() == QVariant::ByteArray) {
+                    object.insert(columnNames.at(columnIndex), QString::fromLatin1(value.toByteArray().toBase64()));
+                }
+                else {
+                    object.insert(columnNames.at(columnIndex), QJsonValue::fromVariant(value));
+                }
+            }
+
+            line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+            line.append('\n');
+        }
+
+        successful = output->write(line) == line.size();
+        if (successful) {
+            rowCount++;
+        }
+    }
+
+    if (successful == false) {
+        LOG_ERROR("Cannot write to the device. Message: " << output->errorString());
+    }
+
+    cursor.close();
+#ifdef QUTILS_ZLIB
+    if (gzipDevice) {
+        gzipDevice->close();
+    }
+#endif // QUTILS_ZLIB
+
+    if (exportedCount) {
+        *exportedCount = rowCount;
+    }
+
+    return successful;
+}
+
+bool SqliteManager::upsertIntoTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row,
+                                    const QStringList &conflictColumns, const QStringList &updateColumns,
+                                    QMap<QString, QVariant> *oldRow, QMap<QString, QVariant> *returnedRow)
+{
+    bool successful = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return successful;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return successful;
+    }
+
+    if (conflictColumns.size() == 0) {
+        LOG_ERROR("Conflict columns cannot be empty!");
+        return successful;
+    }
+
+    const int sqliteVersion = getSqliteVersion(database);
+    // ON CONFLICT is supported since 3.24 and RETURNING since 3.35.
+    const bool isUpsertSupported = sqliteVersion >= 3024000;
+    const bool isReturningSupported = sqliteVersion >= 3035000;
+    Where where;
+    for (const QString &column : conflictColumns) {
+        where.andWhere(column, Where::Operator::EQUAL, row.value(column));
+    }
+
+    // Reading the old row, the write and reading the new row must see the same data.
+    const bool isTransactionNeeded = oldRow || isUpsertSupported == false || (returnedRow && isReturningSupported == false);
+    QScopedPointer<Transaction> transaction(isTransactionNeeded ? new Transaction(*this, database) : nullptr);
+    if (transaction && transaction->isActive() == false) {
+        return successful;
+    }
+
+    QMap<QString, QVariant> existingRow;
+    if (oldRow || isUpsertSupported == false) {
+        const QList<QMap<QString, QVariant>> existingRows = getFromTable(database, tableName, where, 1);
+        existingRow = existingRows.size() > 0 ? existingRows.first() : QMap<QString, QVariant>();
+        if (oldRow) {
+            *oldRow = existingRow;
+        }
+    }
+
+    QStringList quotedConflictColumns, assignments;
+    QMap<QString, QVariant> updatedValues;
+    for (const QString &column : conflictColumns) {
+        quotedConflictColumns.append(Where::quoteIdentifier(column));
+    }
+
+    const QStringList columnsToUpdate = updateColumns.size() > 0 ? updateColumns : row.keys();
+    for (const QString &column : columnsToUpdate) {
+        if (conflictColumns.contains(column) == false) {
+            const QString quotedColumn = Where::quoteIdentifier(column);
+            assignments.append(quotedColumn + "=excluded." + quotedColumn);
+            updatedValues[column] = row.value(column);
+        }
+    }
+
+    if (isUpsertSupported) {
+        QString sqlQueryStr = constructInsertQuery(tableName, row.keys());
+        sqlQueryStr += " ON CONFLICT(" + quotedConflictColumns.join(',') + ")";
+        sqlQueryStr += assignments.size() > 0 ? " DO UPDATE SET " + assignments.join(',') : QString(" DO NOTHING");
+        if (returnedRow && isReturningSupported) {
+            sqlQueryStr += " RETURNING *";
+        }
+
+        QSqlQuery query;
+        if (prepareQuery(database, sqlQueryStr, query) == false) {
+            return successful;
+        }
+
+        bindQueryValues(query, row.values());
+        successful = execQuery(query, sqlQueryStr);
+        if (successful && returnedRow && isReturningSupported) {
+            returnedRow->clear();
+            if (query.next()) {
+                const QSqlRecord record = query.record();
+                for (int columnIndex = 0; columnIndex < record.count(); columnIndex++) {
+                    (*returnedRow)[record.fieldName(columnIndex)] = query.value(columnIndex);
+                }
+            }
+        }
+
+        query.finish();
+        onTableWritten(database, tableName);
+    }
+    else if (existingRow.isEmpty()) {
+        successful = insertIntoTable(database, tableName, row);
+    }
+    else {
+        // Same as DO NOTHING If there's nothing to update.
+        successful = updatedValues.isEmpty() || updateInTable(database, tableName, updatedValues, where);
+    }
+
+    if (successful && returnedRow && isReturningSupported == false) {
+        const QList<QMap<QString, QVariant>> rows = getFromTable(database, tableName, where, 1);
+        *returnedRow = rows.size() > 0 ? rows.first() : QMap<QString, QVariant>();
+    }
+
+    if (successful && transaction) {
+        successful = transaction->commit();
+    }
+
+    return successful;
+}
+
+int SqliteManager::getSqliteVersion(QSqlDatabase &database)
+{
+    ConnectionState &state = getConnectionState(database);
+    if (state.sqliteVersion < 0 && database.isOpen()) {
+        const QString sqlQueryStr = "SELECT sqlite_version()";
+        QSqlQuery query;
+        if (prepareQuery(database, sqlQueryStr, query) == false || execQuery(query, sqlQueryStr) == false || query.next() == false) {
+            return 0;
+        }
+
+        const QStringList parts = query.value(0).toString().split('.');
+        query.finish();
+        state.sqliteVersion = parts.value(0).toInt() * 1000000 + parts.value(1).toInt() * 1000 + parts.value(2).toInt();
+    }
+
+    return qMax(state.sqliteVersion, 0);
+}
+
+bool SqliteManager::updateInTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row, const QList<Constraint> &constraints)
+{
+    return updateInTable(database, tableName, row, toWhere(constraints));
+}
+
+bool SqliteManager::updateInTable(QSqlDatabase &database, const QString &tableName, const QMap<QString, QVariant> &row, const Where &where)
+{
+    bool successful = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return successful;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return successful;
+    }
+
+    if (where.isEmpty()) {
+        LOG_ERROR("Constraints cannot be empty!");
+        return successful;
+    }
+
+    QString sqlQueryStr = "UPDATE " + tableName + " SET ";
+    QStringList newValues;
+    for (auto it = row.constBegin(); it != row.constEnd(); it++) {
+        newValues.append(Where::quoteIdentifier(it.key()) + "=?");
+    }
+
+    sqlQueryStr.append(newValues.join(','));
+    sqlQueryStr.append(" " + where.getQuery());
+
+    QSqlQuery query;
+    if (prepareQuery(database, sqlQueryStr, query) == false) {
+        return successful;
+    }
+
+    // Now bind the values
+    int valueIndex = 0;
+    for (auto it = row.constBegin(); it != row.constEnd(); it++) {
+        query.bindValue(valueIndex, it.value());
+        valueIndex++;
+    }
+
+    bindQueryValues(query, where.getBindValues(), valueIndex);
+    successful = execQuery(query, sqlQueryStr);
+    query.finish();
+    onTableWritten(database, tableName);
+
+    return successful;
+}
+
+bool SqliteManager::deleteInTable(QSqlDatabase &database, const QString &tableName, const QList<Constraint> &constraints)
+{
+    return deleteInTable(database, tableName, toWhere(constraints));
+}
+
+bool SqliteManager::deleteInTable(QSqlDatabase &database, const QString &tableName, const Where &where)
+{
+    bool successful = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return successful;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return successful;
+    }
+
+    QString sqlQueryStr = "DELETE FROM " + tableName;
+    if (where.isEmpty() == false) {
+        sqlQueryStr.append(" " + where.getQuery());
+    }
+
+    QSqlQuery query;
+    if (prepareQuery(database, sqlQueryStr, query) == false) {
+        return successful;
+    }
+
+    bindQueryValues(query, where.getBindValues());
+    successful = execQuery(query, sqlQueryStr);
+    query.finish();
+    onTableWritten(database, tableName);
+
+    return successful;
+}
+
+bool SqliteManager::exists(QSqlDatabase &database, const QString &tableName, const QList<Constraint> &constraints)
+{
+    return exists(database, tableName, toWhere(constraints));
+}
+
+bool SqliteManager::exists(QSqlDatabase &database, const QString &tableName, const Where &where)
+{
+    bool exists = false;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return exists;
+    }
+
+    if (hasTable(database, tableName) == false) {
+        LOG_ERROR("Given table, " << tableName << ", is does not exist!");
+        return exists;
+    }
+
+    if (where.isEmpty()) {
+        LOG_ERROR("Constraints size cannot be 0!");
+        return exists;
+    }
+
+    // EXISTS stops at the first matching row, COUNT would visit all of them.
+    const QString sqlQueryStr = "SELECT EXISTS(SELECT 1 FROM " + tableName + " " + where.getQuery() + ")";
+    QSqlQuery query;
+    if (prepareQuery(database, sqlQueryStr, query) == false) {
+        return exists;
+    }
+
+    bindQueryValues(query, where.getBindValues());
+    if (execQuery(query, sqlQueryStr) && query.next()) {
+        exists = query.value(0).toInt() > 0;
+    }
+
+    query.finish();
+    return exists;
+}
+
+const SqliteManager::SqliteError &SqliteManager::getLastError() const
+{
+    return m_LastError;
+}
+
+QString SqliteManager::getColumnTypeName(const ColumnTypes &type) const
+{
+    QString name = "";
+    if (type == ColumnTypes::TEXT) {
+        name = "TEXT";
+    }
+    else if (type == ColumnTypes::PK_INTEGER) {
+        name = "INTEGER PRIMARY KEY";
+    }
+    else if (type == ColumnTypes::PK_AUTOINCREMENT) {
+        name = "INTEGER PRIMARY KEY AUTOINCREMENT";
+    }
+    else if (type == ColumnTypes::INTEGER) {
+        name = "INTEGER";
+    }
+    else if (type == ColumnTypes::REAL) {
+        name = "REAL";
+    }
+    else if (type == ColumnTypes::BLOB) {
+        name = "BLOB";
+    }
+    else if (type == ColumnTypes::NULL_TYPE) {
+        name = "NULL";
+    }
+
+    return name;
+}
+
+SqliteManager::ColumnTypes SqliteManager::getColumnType(const QString &typeName) const
+{
+    ColumnTypes type = ColumnTypes::NONE;
+    if (typeName == "TEXT") {
+        type = ColumnTypes::TEXT;
+    }
+    else if (typeName == "INTEGER PRIMARY KEY") {
+        type = ColumnTypes::PK_INTEGER;
+    }
+    else if (typeName == "INTEGER PRIMARY KEY AUTOINCREMENT") {
+        type = ColumnTypes::PK_AUTOINCREMENT;
+    }
+    else if (typeName == "INTEGER") {
+        type = ColumnTypes::INTEGER;
+    }
+    else if (typeName == "REAL") {
+        type = ColumnTypes::REAL;
+    }
+    else if (typeName == "BLOB") {
+        type = ColumnTypes::BLOB;
+    }
+    else if (typeName == "NULL") {
+        type = ColumnTypes::NULL_TYPE;
+    }
+
+    return type;
+}
+
+void SqliteManager::setStatementCacheCapacity(int capacity)
+{
+    m_StatementCacheCapacity = capacity < 0 ? 0 : capacity;
+    for (auto it = m_Connections.begin(); it != m_Connections.end(); it++) {
+        it.value().statementCache.shrink(m_StatementCacheCapacity);
+    }
+}
+
+int SqliteManager::getStatementCacheCapacity() const
+{
+    return m_StatementCacheCapacity;
+}
+
+SqliteManager::StatementCacheStats SqliteManager::getStatementCacheStats(const QSqlDatabase &database) const
+{
+    StatementCacheStats stats;
+    auto it = m_Connections.constFind(database.connectionName());
+    if (it != m_Connections.constEnd()) {
+        stats = it.value().statementCache.stats;
+        stats.size = it.value().statementCache.statements.size();
+    }
+
+    return stats;
+}
+
+void SqliteManager::clearStatementCache(const QSqlDatabase &database)
+{
+    auto it = m_Connections.find(database.connectionName());
+    if (it != m_Connections.end()) {
+        it.value().statementCache.clear();
+    }
+}
+
+SqliteManager::PageStats SqliteManager::getPageStats(QSqlDatabase &database)
+{
+    PageStats stats;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return stats;
+    }
+
+    stats.pageSize = executePragma(database, "page_size").toInt();
+    stats.pageCount = executePragma(database, "page_count").toInt();
+    stats.freelistCount = executePragma(database, "freelist_count").toInt();
+    stats.autoVacuum = QStringList({"NONE", "FULL", "INCREMENTAL"}).value(executePragma(database, "auto_vacuum").toInt());
+    return stats;
+}
+
+bool SqliteManager::setAutoVacuum(QSqlDatabase &database, const QString &mode)
+{
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return false;
+    }
+
+    const QString currentMode = getPageStats(database).autoVacuum;
+    if (currentMode.compare(mode, Qt::CaseInsensitive) == 0) {
+        return true;
+    }
+
+    bool ok = false;
+    executePragma(database, "auto_vacuum=" + mode.toUpper(), &ok);
+    if (ok == false) {
+        return false;
+    }
+
+    // Switching between NONE and the other modes needs the file to be rebuilt. An empty database is not affected by the VACUUM.
+    ok = executeQuery(database, "VACUUM");
+    if (ok && getPageStats(database).autoVacuum.compare(mode, Qt::CaseInsensitive) != 0) {
+        LOG_ERROR("auto_vacuum could not be changed to " << mode);
+        ok = false;
+    }
+
+    return ok;
+}
+
+int SqliteManager::incrementalVacuum(QSqlDatabase &database, int pageCount)
+{
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return -1;
+    }
+
+    const int freelistCount = executePragma(database, "freelist_count").toInt();
+    // incremental_vacuum frees one page for every row it returns, so it has to be stepped until the end.
+    Cursor cursor = openCursor(database, "PRAGMA incremental_vacuum(" + QString::number(qMax(pageCount, 0)) + ")");
+    if (cursor.isValid() == false) {
+        return -1;
+    }
+
+    while (cursor.next()) {
+    }
+
+    cursor.close();
+    return freelistCount - executePragma(database, "freelist_count").toInt();
+}
+
+bool SqliteManager::optimize(QSqlDatabase &database)
+{
+    bool ok = false;
+    executePragma(database, "optimize", &ok);
+    return ok;
+}
+
+bool SqliteManager::analyze(QSqlDatabase &database, int analysisLimit)
+{
+    if (analysisLimit > 0) {
+        bool ok = false;
+        executePragma(database, "analysis_limit=" + QString::number(analysisLimit), &ok);
+        if (ok == false) {
+            return false;
+        }
+    }
+
+    return executeQuery(database, "ANALYZE");
+}
+
+qint64 SqliteManager::getIdleTime(const QSqlDatabase &database) const
+{
+    // The other managers of the connection count as well, so the shared state is looked up even If this manager has not used it.
+    SharedConnectionRegistry &registry = getSharedConnectionRegistry();
+    QSharedPointer<SharedConnectionState> state;
+    QMutexLocker locker(&registry.mutex);
+    state = registry.states.value(database.connectionName()).toStrongRef();
+    if (state.isNull() || state->handle != getHandle(database) || state->activityTimer.isValid() == false) {
+        return -1;
+    }
+
+    return state->activityTimer.elapsed();
+}
+
+void SqliteManager::setActivityTracked(bool isTracked)
+{
+    m_IsActivityTracked = isTracked;
+}
+
+bool SqliteManager::isActivityTracked() const
+{
+    return m_IsActivityTracked;
+}
+
+void SqliteManager::setQueryStatsEnabled(bool enabled)
+{
+    m_IsQueryStatsEnabled = enabled;
+}
+
+bool SqliteManager::isQueryStatsEnabled() const
+{
+    return m_IsQueryStatsEnabled;
+}
+
+QList<SqliteManager::QueryStats> SqliteManager::getQueryStats() const
+{
+    QList<QueryStats> statsList;
+    for (auto it = m_QueryStats.constBegin(); it != m_QueryStats.constEnd(); it++) {
+        QueryStats stats = it.value().stats;
+        QVector<qint64> samples = it.value().samples;
+        if (samples.size() > 0) {
+            std::sort(samples.begin(), samples.end());
+            stats.p95Time = samples.at(qMin(samples.size() - 1, static_cast<int>(samples.size() * 0.95)));
+        }
+
+        statsList.append(stats);
+    }
+
+    std::sort(statsList.begin(), statsList.end(), [](const QueryStats &first, const QueryStats &second) {
+        return first.totalTime > second.totalTime;
+    });
+
+    return statsList;
+}
+
+QByteArray SqliteManager::getQueryStatsJson() const
+{
+    QJsonArray array;
+    for (const QueryStats &stats : getQueryStats()) {
+        array.append(QJsonObject::fromVariantMap(stats.toMap()));
+    }
+
+    return QJsonDocument(array).toJson(QJsonDocument::Compact);
+}
+
+void SqliteManager::resetQueryStats()
+{
+    m_QueryStats.clear();
+    m_NormalizedQueries.clear();
+}
+
+void SqliteManager::setSlowQueryThreshold(int milliseconds)
+{
+    m_SlowQueryThreshold = milliseconds;
+}
+
+int SqliteManager::getSlowQueryThreshold() const
+{
+    return m_SlowQueryThreshold;
+}
+
+void SqliteManager::setSlowQueryCallback(const SlowQueryCallback &callback)
+{
+    m_SlowQueryCallback = callback;
+}
+
+void SqliteManager::updateError(QSqlDatabase &db, const QString &query)
+{
+    m_LastError.error = db.lastError();
+    m_LastError.query = query;
+}
+
+void SqliteManager::updateError(const QSqlQuery &query, const QString &sqlQueryStr)
+{
+    m_LastError.error = query.lastError();
+    m_LastError.query = sqlQueryStr;
+}
+
+void *SqliteManager::getHandle(const QSqlDatabase &database)
+{
+    return database.isOpen() ? getHandle(database.driver()) : nullptr;
+}
+
+void *SqliteManager::getHandle(const QSqlDriver *driver)
+{
+    void *handle = nullptr;
+    if (driver) {
+        const QVariant handleVar = driver->handle();
+        if (handleVar.isValid() && qstrcmp(handleVar.typeName(), "sqlite3*") == 0) {
+            handle = *static_cast<void *const *>(handleVar.constData());
+        }
+    }
+
+    return handle;
+}
+
+void *SqliteManager::getStatementHandle(const QSqlQuery &query)
+{
+    void *handle = nullptr;
+    if (query.result()) {
+        const QVariant handleVar = query.result()->handle();
+        if (handleVar.isValid() && qstrcmp(handleVar.typeName(), "sqlite3_stmt*") == 0) {
+            handle = *static_cast<void *const *>(handleVar.constData());
+        }
+    }
+
+    return handle;
+}
+
+void SqliteManager::markActivity(const QSqlQuery &query)
+{
+    if (m_IsActivityTracked == false) {
+        return;
+    }
+
+    // The query does not know its connection name, but it knows its handle. There are only a few connections per manager.
+    void *handle = getHandle(query.driver());
+    for (auto it = m_Connections.begin(); it != m_Connections.end(); it++) {
+        if (it.value().handle == handle && it.value().shared) {
+            it.value().shared->activityTimer.start();
+            break;
+        }
+    }
+}
+
+SqliteManager::ConnectionState &SqliteManager::getConnectionState(const QSqlDatabase &database)
+{
+    ConnectionState &state = m_Connections[database.connectionName()];
+    void *handle = getHandle(database);
+    if (state.handle != handle) {
+        // The connection was closed and opened again, nothing we have cached is valid anymore.
+        state = ConnectionState();
+        state.handle = handle;
+        if (handle) {
+            state.shared = acquireSharedState(database.connectionName(), handle);
+        }
+    }
+
+    return state;
+}
+
+bool SqliteManager::prepareQuery(QSqlDatabase &database, const QString &sqlQueryStr, QSqlQuery &query)
+{
+    // Only the surrounding whitespace is trimmed, collapsing the inner whitespace could change string literals.
+    const QString key = sqlQueryStr.trimmed();
+    StatementCache &cache = getConnectionState(database).statementCache;
+    auto it = cache.statements.find(key);
+    // An active statement is still being stepped by someone up in the call stack, so we cannot reset it.
+    if (it != cache.statements.end() && it.value().query.isActive() == false) {
+        cache.stats.hits++;
+        cache.markUsed(it.value());
+        query = it.value().query;
+        return true;
+    }
+
+    cache.stats.misses++;
+    query = QSqlQuery(database);
+    query.setForwardOnly(true);
+    if (query.prepare(key) == false) {
+        // Most likely the schema was changed behind our back (e.g a missing table or column).
+        getConnectionState(database).schemaCache = SchemaCache();
+        updateError(query, key);
+        LOG_ERROR("Error occurred. Message: " << query.lastError().text() << ". Query: " << key);
+        return false;
+    }
+
+    if (m_StatementCacheCapacity > 0 && it == cache.statements.end() && isCacheableStatement(key)) {
+        cache.insert(key, query);
+        cache.shrink(m_StatementCacheCapacity);
+    }
+
+    return true;
+}
+
+bool SqliteManager::isCacheableStatement(const QString &sqlQueryStr)
+{
+    static const QStringList cacheableStatements = {"SELECT", "INSERT", "UPDATE", "DELETE", "REPLACE", "WITH"};
+    const QString statement = sqlQueryStr.section(QRegExp("\\s"), 0, 0, QString::SectionSkipEmpty).toUpper();
+    return cacheableStatements.contains(statement);
+}
+
+QString SqliteManager::constructSelectQuery(const QString &tableName, const QStringList &columns, const unsigned int &limit,
+        const Where &where, const SelectOrder *selectOrder, QVariantList &values) const
+{
+    QString sqlQueryStr = "SELECT ";
+    if (columns.isEmpty()) {
+        sqlQueryStr += "*";
+    }
+    else {
+        QStringList quotedColumns;
+        for (const QString &column : columns) {
+            quotedColumns.append(Where::quoteIdentifier(column));
+        }
+
+        sqlQueryStr += quotedColumns.join(',');
+    }
+
+    sqlQueryStr += " FROM " + tableName;
+    values = where.getBindValues();
+    if (where.isEmpty() == false) {
+        sqlQueryStr += " " + where.getQuery();
+    }
+
+    if (selectOrder && selectOrder->fieldName.length() > 0) {
+        const QString orderType = selectOrder->order == SelectOrder::OrderType::ASC ? "ASC" : "DESC";
+        sqlQueryStr += " ORDER BY " + selectOrder->fieldName + " " + orderType;
+    }
+
+    // The limit is bound as well, so that different limits share the same statement.
+    if (limit > 0) {
+        sqlQueryStr += " LIMIT ?";
+        values.append(limit);
+    }
+
+    return sqlQueryStr;
+}
+
+SqliteManager::Where SqliteManager::toWhere(const QList<Constraint> &constraints) const
+{
+    Where where;
+    for (int index = 0; index < constraints.size(); index++) {
+        const Constraint &constraint = constraints.at(index);
+        // The column names were spliced into the query as they are, callers may rely on expressions like `lower(name)`. So they are
+        // not quoted here. The joiner of a constraint is placed after it, so the previous one decides how this one is joined.
+        if (index > 0 && std::get<2>(constraints.at(index - 1)).trimmed().toUpper() == "OR") {
+            where.orWhereExpression(std::get<0>(constraint), Where::Operator::EQUAL, std::get<1>(constraint));
+        }
+        else {
+            where.andWhereExpression(std::get<0>(constraint), Where::Operator::EQUAL, std::get<1>(constraint));
+        }
+    }
+
+    return where;
+}
+
+void SqliteManager::bindQueryValues(QSqlQuery &query, const QVariantList &values, int startIndex) const
+{
+    for (int index = 0; index < values.size(); index++) {
+        query.bindValue(startIndex + index, values.at(index));
+    }
+}
+
+QByteArray SqliteManager::readDeviceLine(QIODevice *device, int readTimeout)
+{
+    QByteArray line = device->readLine();
+    while (device->isSequential() && line.endsWith('\n') == false) {
+        if (device->canReadLine() == false && device->waitForReadyRead(readTimeout) == false) {
+            // No more data, the last line may not have a newline.
+            if (device->bytesAvailable() > 0) {
+                line += device->readAll();
+            }
+
+            break;
+        }
+
+        line += device->readLine();
+    }
+
+    return line;
+}
+
+bool SqliteManager::readCsvRecord(QIODevice *device, const QChar &delimiter, QStringList &fields, qint64 &bytesRead, int readTimeout)
+{
+    fields.clear();
+    QString field;
+    bool isInQuotes = false, hasRecord = false;
+    do {
+        const QByteArray lineBytes = readDeviceLine(device, readTimeout);
+        if (lineBytes.isEmpty()) {
+            break;
+        }
+
+        hasRecord = true;
+        bytesRead += lineBytes.size();
+        const QString line = QString::fromUtf8(lineBytes);
+        for (int charIndex = 0; charIndex < line.size(); charIndex++) {
+            const QChar character = line.at(charIndex);
+            if (isInQuotes) {
+                if (character != '"') {
+                    field += character;
+                }
+                else if (charIndex + 1 < line.size() && line.at(charIndex + 1) == '"') {
+                    field += character;
+                    charIndex++;
+                }
+                else {
+                    isInQuotes = false;
+                }
+            }
+            else if (character == '"') {
+                isInQuotes = true;
+            }
+            else if (character == delimiter) {
+                fields.append(field);
+                field.clear();
+            }
+            else if (character != '\n' && character != '\r') {
+                field += character;
+            }
+        }
+    } while (isInQuotes);
+
+    if (hasRecord) {
+        fields.append(field);
+    }
+
+    return hasRecord;
+}
+
+QString SqliteManager::escapeCsvField(const QString &field, const QChar &delimiter)
+{
+    if (field.contains(delimiter) || field.contains('"') || field.contains('\n') || field.contains('\r')) {
+        QString escaped = field;
+        return "\"" + escaped.replace("\"", "\"\"") + "\"";
+    }
+
+    return field;
+}
+
+QString SqliteManager::normalizeQuery(const QString &sqlQueryStr)
+{
+    QString normalized;
+    normalized.reserve(sqlQueryStr.size());
+    const int length = sqlQueryStr.size();
+    for (int charIndex = 0; charIndex < length; charIndex++) {
+        const QChar character = sqlQueryStr.at(charIndex);
+        if (character == '\'') {
+            // Skip to the closing quote, '' is an escaped quote.
+            charIndex++;
+            while (charIndex < length) {
+                if (sqlQueryStr.at(charIndex) == '\'') {
+                    if (charIndex + 1 < length && sqlQueryStr.at(charIndex + 1) == '\'') {
+                        charIndex += 2;
+                        continue;
+                    }
+
+                    break;
+                }
+
+                charIndex++;
+            }
+
+            normalized += '?';
+        }
+        else if (character == '"') {
+            // Quoted identifiers are kept as they are.
+            const int endIndex = sqlQueryStr.indexOf('"', charIndex + 1);
+            const int identifierEnd = endIndex == -1 ? length - 1 : endIndex;
+            normalized += sqlQueryStr.mid(charIndex, identifierEnd - charIndex + 1);
+            charIndex = identifierEnd;
+        }
+        else if (character.isDigit() && (normalized.isEmpty() || (normalized.at(normalized.size() - 1).isLetterOrNumber() == false &&
+                                         normalized.at(normalized.size() - 1) != '_'))) {
+            while (charIndex + 1 < length && (sqlQueryStr.at(charIndex + 1).isLetterOrNumber() || sqlQueryStr.at(charIndex + 1) == '.')) {
+                charIndex++;
+            }
+
+            normalized += '?';
+        }
+        else if (character.isSpace()) {
+            if (normalized.isEmpty() == false && normalized.at(normalized.size() - 1) != ' ') {
+                normalized += ' ';
+            }
+        }
+        else {
+            normalized += character;
+        }
+    }
+
+    return normalized.trimmed();
+}
+
+SqliteManager::QueryStatsEntry &SqliteManager::getQueryStatsEntry(const QString &sqlQueryStr)
+{
+    auto normalizedIt = m_NormalizedQueries.constFind(sqlQueryStr);
+    if (normalizedIt == m_NormalizedQueries.constEnd()) {
+        // Queries with spliced values are all different, do not let the lookup table grow without a limit.
+        if (m_NormalizedQueries.size() >= 1000) {
+            m_NormalizedQueries.clear();
+        }
+
+        normalizedIt = m_NormalizedQueries.insert(sqlQueryStr, normalizeQuery(sqlQueryStr));
+    }
+
+    QueryStatsEntry &entry = m_QueryStats[normalizedIt.value()];
+    if (entry.stats.query.isEmpty()) {
+        entry.stats.query = normalizedIt.value();
+    }
+
+    return entry;
+}
+
+void SqliteManager::recordExecution(const QSqlQuery &query, const QString &sqlQueryStr, qint64 elapsed, bool successful)
+{
+    static const int maxSampleCount = 512;
+    QueryStatsEntry &entry = getQueryStatsEntry(sqlQueryStr);
+    entry.stats.callCount++;
+    entry.stats.totalTime += elapsed;
+    entry.stats.maxTime = qMax(entry.stats.maxTime, elapsed);
+    if (successful == false) {
+        entry.stats.failedCount++;
+    }
+    else if (query.isSelect() == false) {
+        entry.stats.rowsChanged += qMax(query.numRowsAffected(), 0);
+    }
+
+    if (entry.samples.size() < maxSampleCount) {
+        entry.samples.append(elapsed);
+    }
+    else {
+        entry.samples[entry.nextSampleIndex] = elapsed;
+        entry.nextSampleIndex = (entry.nextSampleIndex + 1) % maxSampleCount;
+    }
+}
+
+void SqliteManager::recordFetch(const QString &sqlQueryStr, qint64 rowCount, qint64 elapsed)
+{
+    QueryStatsEntry &entry = getQueryStatsEntry(sqlQueryStr);
+    entry.stats.rowsReturned += rowCount;
+    entry.stats.fetchTime += elapsed;
+}
+
+QString SqliteManager::constructInsertQuery(const QString &tableName, const QStringList &columnNames) const
+{
+    QStringList valuePlaceholders;
+    for (int index = 0; index < columnNames.size(); index++) {
+        valuePlaceholders.append("?");
+    }
+
+    return "INSERT INTO " + tableName + " (" + columnNames.join(',') + ") VALUES(" + valuePlaceholders.join(',') + ")";
+}
+
+QVariant SqliteManager::executePragma(QSqlDatabase &database, const QString &pragma, bool *ok)
+{
+    QVariant value;
+    const QString sqlQueryStr = "PRAGMA " + pragma;
+    QSqlQuery query;
+    const bool successful = prepareQuery(database, sqlQueryStr, query) && execQuery(query, sqlQueryStr);
+    if (successful) {
+        if (query.next()) {
+            value = query.value(0);
+        }
+
+        query.finish();
+    }
+
+    if (ok) {
+        *ok = successful;
+    }
+
+    return value;
+}
+
+int SqliteManager::readSchemaVersion(QSqlDatabase &database)
+{
+    // This is bookkeeping, it does not go through execQuery() so it is not counted in the stats or as activity.
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (query.exec("PRAGMA schema_version") == false || query.next() == false) {
+        LOG_ERROR("Cannot read the schema version. Message: " << query.lastError().text());
+        return -1;
+    }
+
+    const int version = query.value(0).toInt();
+    query.finish();
+    return version;
+}
+
+bool SqliteManager::refreshSchemaCache(QSqlDatabase &database)
+{
+    const int version = readSchemaVersion(database);
+    if (version == -1) {
+        return false;
+    }
+
+    if (getConnectionState(database).schemaCache.schemaVersion == version) {
+        return true;
+    }
+
+    const QString sqlQueryStr = "SELECT name FROM sqlite_master WHERE type='table'";
+    QSqlQuery query;
+    if (prepareQuery(database, sqlQueryStr, query) == false || execQuery(query, sqlQueryStr) == false) {
+        return false;
+    }
+
+    SchemaCache schemaCache;
+    schemaCache.schemaVersion = version;
+    while (query.next()) {
+        schemaCache.tables.insert(query.value(0).toString().toLower(), QList<ColumnDefinition>());
+    }
+
+    query.finish();
+    getConnectionState(database).schemaCache = schemaCache;
+    return true;
+}
+
+bool SqliteManager::hasTable(QSqlDatabase &database, const QString &tableName)
+{
+    // A cached table is trusted. If it was dropped from another connection the statement fails to prepare, and prepareQuery() clears
+    // the cache.
+    const QString key = tableName.toLower();
+    const SchemaCache &schemaCache = getConnectionState(database).schemaCache;
+    if (schemaCache.schemaVersion != -1 && schemaCache.tables.contains(key)) {
+        return true;
+    }
+
+    // The table may have been created from another connection.
+    return refreshSchemaCache(database) && getConnectionState(database).schemaCache.tables.contains(key);
+}
+
+void SqliteManager::updateSchemaCache(QSqlDatabase &database, const QString &tableName, const QList<ColumnDefinition> &columns,
+                                      bool isDropped)
+{
+    const int previousVersion = getConnectionState(database).schemaCache.schemaVersion;
+    const int version = readSchemaVersion(database);
+    SchemaCache &schemaCache = getConnectionState(database).schemaCache;
+    // Every schema change increments the version by one. If the difference is bigger, someone else also changed the schema.
+    if (previousVersion == -1 || version != previousVersion + 1) {
+        schemaCache = SchemaCache();
+        return;
+    }
+
+    schemaCache.schemaVersion = version;
+    if (isDropped) {
+        schemaCache.tables.remove(tableName.toLower());
+    }
+    else {
+        schemaCache.tables.insert(tableName.toLower(), columns);
+    }
+}
+
+bool SqliteManager::execQuery(QSqlQuery &query, const QString &sqlQueryStr)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const bool successful = query.exec();
+    const qint64 elapsed = timer.nsecsElapsed() / 1000;
+    markActivity(query);
+    if (m_IsQueryStatsEnabled) {
+        recordExecution(query, sqlQueryStr, elapsed, successful);
+    }
+
+    if (m_SlowQueryThreshold >= 0 && elapsed >= m_SlowQueryThreshold * 1000LL) {
+        QVariantList bindValues;
+        const int bindValueCount = query.boundValues().size();
+        for (int index = 0; index < bindValueCount; index++) {
+            bindValues.append(query.boundValue(index));
+        }
+
+        if (m_SlowQueryCallback) {
+            m_SlowQueryCallback(sqlQueryStr, bindValues, elapsed);
+        }
+        else {
+            LOG_WARNING("Slow query took " << elapsed / 1000.0 << "ms. Query: " << sqlQueryStr << ". Values: " << bindValues);
+        }
+    }
+
+    if (successful == false) {
+        updateError(query, sqlQueryStr);
+        LOG_ERROR("Error occurred. Message: " << query.lastError().text() << ". Query: " << sqlQueryStr);
+    }
+
+    return successful;
 }
 
 }
@@ -0,0 +1,201 @@
+#include "qutils/SqliteMigrator.h"
+// Qt
+#include <QElapsedTimer>
+// qutils
+#include "qutils/Macros.h"
+
+namespace zmc
+{
+
+SqliteMigrator::SqliteMigrator(SqliteManager &manager)
+    : m_Manager(manager)
+    , m_Migrations()
+{
+
+}
+
+SqliteMigrator &SqliteMigrator::addMigration(int version, const QString &description, const QStringList &statements)
+{
+    if (version < 1) {
+        LOG_ERROR("Migration version must be greater than 0!");
+        return *this;
+    }
+
+    Migration migration;
+    migration.description = description;
+    migration.statements = statements;
+    m_Migrations.insert(version, migration);
+    return *this;
+}
+
+SqliteMigrator &SqliteMigrator::addMigration(int version, const QString &description, const MigrationFunction &function)
+{
+    if (version < 1) {
+        LOG_ERROR("Migration version must be greater than 0!");
+        return *this;
+    }
+
+    Migration migration;
+    migration.description = description;
+    migration.function = function;
+    m_Migrations.insert(version, migration);
+    return *this;
+}
+
+int SqliteMigrator::getCurrentVersion(QSqlDatabase &database) const
+{
+    const QList<QMap<QString, QVariant>> rows = m_Manager.executeSelectQuery(database, "PRAGMA user_version");
+    return rows.size() > 0 ? rows.first().value("user_version", -1).toInt() : -1;
+}
+
+int SqliteMigrator::getLatestVersion() const
+{
+    return m_Migrations.size() > 0 ? m_Migrations.lastKey() : 0;
+}
+
+SqliteMigrator::Result SqliteMigrator::migrate(QSqlDatabase &database, int targetVersion)
+{
+    Result result;
+    if (database.isOpen() == false) {
+        LOG_ERROR("Given database is not open!");
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    result.fromVersion = getCurrentVersion(database);
+    result.toVersion = result.fromVersion;
+    if (result.fromVersion < 0) {
+        LOG_ERROR("Cannot read the version of the database!");
+        return result;
+    }
+
+    if (targetVersion < 0) {
+        targetVersion = getLatestVersion();
+    }
+
+    if (result.fromVersion > targetVersion) {
+        LOG_ERROR("Database version " << result.fromVersion << " is newer than the target version " << targetVersion << "!");
+        return result;
+    }
+
+    if (result.fromVersion == targetVersion) {
+        result.isSuccessful = true;
+        return result;
+    }
+
+    SqliteManager::Transaction transaction(m_Manager, database);
+    if (transaction.isActive() == false) {
+        return result;
+    }
+
+    int version = result.fromVersion;
+    for (auto it = m_Migrations.upperBound(result.fromVersion); it != m_Migrations.constEnd() && it.key() <= targetVersion; it++) {
+        const Migration &migration = it.value();
+        StepResult step;
+        step.version = it.key();
+        step.description = migration.description;
+
+        QElapsedTimer stepTimer;
+        stepTimer.start();
+        if (migration.function) {
+            step.isSuccessful = migration.function(m_Manager, database);
+        }
+        else {
+            step.isSuccessful = true;
+            for (const QString &statement : migration.statements) {
+                if (m_Manager.executeQuery(database, statement) == false) {
+                    step.isSuccessful = false;
+                    break;
+                }
+            }
+        }
+
+        step.elapsed = stepTimer.elapsed();
+        if (step.isSuccessful == false) {
+            step.error = m_Manager.getLastError().error;
+            LOG_ERROR("Migration to version " << step.version << " failed. Message: " << step.error.text());
+            result.steps.append(step);
+            result.elapsed = timer.elapsed();
+            // The transaction is rolled back when it goes out of scope.
+            return result;
+        }
+
+        result.steps.append(step);
+        version = step.version;
+    }
+
+    // Functions may also change the schema with their own queries.
+    m_Manager.invalidateSchemaCache(database);
+    if (m_Manager.executeQuery(database, "PRAGMA user_version = " + QString::number(version)) == false || transaction.commit() == false) {
+        LOG_ERROR("Cannot commit the migration. Message: " << m_Manager.getLastError().error.text());
+        result.elapsed = timer.elapsed();
+        return result;
+    }
+
+    result.toVersion = version;
+    result.isSuccessful = true;
+    result.elapsed = timer.elapsed();
+    return result;
+}
+
+QString SqliteMigrator::addColumn(const QString &tableName, const SqliteManager::ColumnDefinition &column, const QString &defaultValue) const
+{
+    QString sqlQueryStr = "ALTER TABLE " + SqliteWhere::quoteIdentifier(tableName) + " ADD COLUMN " + getColumnDefinitionText(column);
+    if (defaultValue.isEmpty() == false) {
+        sqlQueryStr += " DEFAULT " + defaultValue;
+    }
+
+    return sqlQueryStr;
+}
+
+QString SqliteMigrator::renameTable(const QString &tableName, const QString &newTableName) const
+{
+    return "ALTER TABLE " + SqliteWhere::quoteIdentifier(tableName) + " RENAME TO " + SqliteWhere::quoteIdentifier(newTableName);
+}
+
+QString SqliteMigrator::renameColumn(const QString &tableName, const QString &columnName, const QString &newColumnName) const
+{
+    return "ALTER TABLE " + SqliteWhere::quoteIdentifier(tableName) + " RENAME COLUMN " + SqliteWhere::quoteIdentifier(columnName) +
+           " TO " + SqliteWhere::quoteIdentifier(newColumnName);
+}
+
+QString SqliteMigrator::copyRows(const QString &sourceTableName, const QString &targetTableName,
+                                 const QMap<QString, QString> &columnExpressions) const
+{
+    QStringList targetColumns, sourceExpressions;
+    for (auto it = columnExpressions.constBegin(); it != columnExpressions.constEnd(); it++) {
+        targetColumns.append(SqliteWhere::quoteIdentifier(it.key()));
+        sourceExpressions.append(it.value().isEmpty() ? SqliteWhere::quoteIdentifier(it.key()) : it.value());
+    }
+
+    return "INSERT INTO " + SqliteWhere::quoteIdentifier(targetTableName) + " (" + targetColumns.join(',') + ") SELECT " +
+           sourceExpressions.join(',') + " FROM " + SqliteWhere::quoteIdentifier(sourceTableName);
+}
+
+QStringList SqliteMigrator::rebuildTable(const QString &tableName, const QList<SqliteManager::ColumnDefinition> &columns,
+        const QMap<QString, QString> &columnExpressions) const
+{
+    const QString newTableName = tableName + "_migration_new";
+    QStringList columnDefinitions;
+    QMap<QString, QString> expressions;
+    for (const SqliteManager::ColumnDefinition &column : columns) {
+        columnDefinitions.append(getColumnDefinitionText(column));
+        expressions.insert(column.name, columnExpressions.value(column.name));
+    }
+
+    return QStringList {
+        "CREATE TABLE " + SqliteWhere::quoteIdentifier(newTableName) + " (" + columnDefinitions.join(',') + ")",
+        copyRows(tableName, newTableName, expressions),
+        "DROP TABLE " + SqliteWhere::quoteIdentifier(tableName),
+        renameTable(newTableName, tableName)
+    };
+}
+
+QString SqliteMigrator::getColumnDefinitionText(const SqliteManager::ColumnDefinition &column) const
+{
+    return (SqliteWhere::quoteIdentifier(column.name) + " " + m_Manager.getColumnTypeName(column.type) + " " + column.getNullText()).trimmed();
+}
+
+}
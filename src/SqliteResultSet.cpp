@@ -0,0 +1,360 @@
+#include "qutils/SqliteResultSet.h"
+// Qt
+#include <QSqlQuery>
+
+namespace zmc
+{
+
+SqliteResultSet::RowView::RowView(const SqliteResultSet *resultSet, int rowIndex)
+    : m_ResultSet(resultSet)
+    , m_RowIndex(rowIndex)
+{
+
+}
+
+int SqliteResultSet::RowView::getRowIndex() const
+{
+    return m_RowIndex;
+}
+
+bool SqliteResultSet::RowView::isNull(int columnIndex) const
+{
+    return m_ResultSet->m_Columns.at(columnIndex).nulls.at(m_RowIndex);
+}
+
+QVariant SqliteResultSet::RowView::value(int columnIndex) const
+{
+    return m_ResultSet->getValue(columnIndex, m_RowIndex);
+}
+
+QVariant SqliteResultSet::RowView::value(const QString &columnName) const
+{
+    const int columnIndex = m_ResultSet->getColumnIndex(columnName);
+    return columnIndex == -1 ? QVariant() : m_ResultSet->getValue(columnIndex, m_RowIndex);
+}
+
+qint64 SqliteResultSet::RowView::toInteger(int columnIndex) const
+{
+    const Column &column = m_ResultSet->m_Columns.at(columnIndex);
+    if (column.type == StorageType::INTEGER) {
+        return column.integers.at(m_RowIndex);
+    }
+
+    return value(columnIndex).toLongLong();
+}
+
+double SqliteResultSet::RowView::toReal(int columnIndex) const
+{
+    const Column &column = m_ResultSet->m_Columns.at(columnIndex);
+    if (column.type == StorageType::REAL) {
+        return column.reals.at(m_RowIndex);
+    }
+
+    return value(columnIndex).toDouble();
+}
+
+QString SqliteResultSet::RowView::toText(int columnIndex) const
+{
+    const Column &column = m_ResultSet->m_Columns.at(columnIndex);
+    if (column.type == StorageType::TEXT) {
+        return column.texts.at(m_RowIndex);
+    }
+
+    return value(columnIndex).toString();
+}
+
+QByteArray SqliteResultSet::RowView::toBlob(int columnIndex) const
+{
+    const Column &column = m_ResultSet->m_Columns.at(columnIndex);
+    if (column.type == StorageType::BLOB) {
+        return column.blobs.at(m_RowIndex);
+    }
+
+    return value(columnIndex).toByteArray();
+}
+
+QMap<QString, QVariant> SqliteResultSet::RowView::toMap() const
+{
+    QMap<QString, QVariant> row;
+    for (int columnIndex = 0; columnIndex < m_ResultSet->getColumnCount(); columnIndex++) {
+        row[m_ResultSet->m_ColumnNames.at(columnIndex)] = value(columnIndex);
+    }
+
+    return row;
+}
+
+SqliteResultSet::SqliteResultSet()
+    : m_ColumnNames()
+    , m_Columns()
+    , m_RowCount(0)
+{
+
+}
+
+SqliteResultSet::SqliteResultSet(const QStringList &columnNames)
+    : m_ColumnNames()
+    , m_Columns()
+    , m_RowCount(0)
+{
+    setColumnNames(columnNames);
+}
+
+void SqliteResultSet::clear()
+{
+    m_ColumnNames.clear();
+    m_Columns.clear();
+    m_RowCount = 0;
+}
+
+void SqliteResultSet::setColumnNames(const QStringList &columnNames)
+{
+    m_ColumnNames = columnNames;
+    m_Columns = QVector<Column>(columnNames.size());
+    m_RowCount = 0;
+}
+
+QStringList SqliteResultSet::getColumnNames() const
+{
+    return m_ColumnNames;
+}
+
+int SqliteResultSet::getColumnIndex(const QString &columnName) const
+{
+    return m_ColumnNames.indexOf(columnName);
+}
+
+int SqliteResultSet::getColumnCount() const
+{
+    return m_ColumnNames.size();
+}
+
+int SqliteResultSet::getRowCount() const
+{
+    return m_RowCount;
+}
+
+bool SqliteResultSet::isEmpty() const
+{
+    return m_RowCount == 0;
+}
+
+SqliteResultSet::StorageType SqliteResultSet::getStorageType(int columnIndex) const
+{
+    return m_Columns.at(columnIndex).type;
+}
+
+void SqliteResultSet::reserve(int rowCount)
+{
+    for (Column &column : m_Columns) {
+        column.nulls.reserve(rowCount);
+        if (column.type == StorageType::INTEGER) {
+            column.integers.reserve(rowCount);
+        }
+        else if (column.type == StorageType::REAL) {
+            column.reals.reserve(rowCount);
+        }
+        else if (column.type == StorageType::TEXT) {
+            column.texts.reserve(rowCount);
+        }
+        else if (column.type == StorageType::BLOB) {
+            column.blobs.reserve(rowCount);
+        }
+        else if (column.type == StorageType::VARIANT) {
+            column.variants.reserve(rowCount);
+        }
+    }
+}
+
+void SqliteResultSet::appendRow(const QSqlQuery &query)
+{
+    for (int columnIndex = 0; columnIndex < m_Columns.size(); columnIndex++) {
+        appendValue(m_Columns[columnIndex], query.value(columnIndex));
+    }
+
+    m_RowCount++;
+}
+
+void SqliteResultSet::appendRow(const QVariantList &values)
+{
+    for (int columnIndex = 0; columnIndex < m_Columns.size(); columnIndex++) {
+        appendValue(m_Columns[columnIndex], columnIndex < values.size() ? values.at(columnIndex) : QVariant());
+    }
+
+    m_RowCount++;
+}
+
+SqliteResultSet::RowView SqliteResultSet::at(int rowIndex) const
+{
+    return RowView(this, rowIndex);
+}
+
+SqliteResultSet::RowView SqliteResultSet::operator[](int rowIndex) const
+{
+    return RowView(this, rowIndex);
+}
+
+SqliteResultSet::const_iterator SqliteResultSet::begin() const
+{
+    return const_iterator(this, 0);
+}
+
+SqliteResultSet::const_iterator SqliteResultSet::end() const
+{
+    return const_iterator(this, m_RowCount);
+}
+
+QList<QMap<QString, QVariant>> SqliteResultSet::toList() const
+{
+    QList<QMap<QString, QVariant>> rows;
+    rows.reserve(m_RowCount);
+    for (int rowIndex = 0; rowIndex < m_RowCount; rowIndex++) {
+        rows.append(at(rowIndex).toMap());
+    }
+
+    return rows;
+}
+
+void SqliteResultSet::appendValue(Column &column, const QVariant &value)
+{
+    const bool isNull = value.isNull();
+    if (isNull == false && column.type != StorageType::VARIANT) {
+        const StorageType valueType = getValueStorageType(value);
+        if (column.type == StorageType::NONE) {
+            // The first non-null value decides the type of the column. All of the previous values are NULL.
+            column.type = valueType;
+            const int previousRowCount = column.nulls.size();
+            if (valueType == StorageType::INTEGER) {
+                column.integers.resize(previousRowCount);
+            }
+            else if (valueType == StorageType::REAL) {
+                column.reals.resize(previousRowCount);
+            }
+            else if (valueType == StorageType::TEXT) {
+                column.texts.resize(previousRowCount);
+            }
+            else if (valueType == StorageType::BLOB) {
+                column.blobs.resize(previousRowCount);
+            }
+            else {
+                column.variants.resize(previousRowCount);
+            }
+        }
+        else if (column.type != valueType) {
+            convertToVariant(column);
+        }
+    }
+
+    column.nulls.append(isNull);
+    switch (column.type) {
+    case StorageType::NONE:
+        break;
+    case StorageType::INTEGER:
+        column.integers.append(isNull ? 0 : value.toLongLong());
+        break;
+    case StorageType::REAL:
+        column.reals.append(isNull ? 0.0 : value.toDouble());
+        break;
+    case StorageType::TEXT:
+        column.texts.append(isNull ? QString() : value.toString());
+        break;
+    case StorageType::BLOB:
+        column.blobs.append(isNull ? QByteArray() : value.toByteArray());
+        break;
+    case StorageType::VARIANT:
+        column.variants.append(value);
+        break;
+    }
+}
+
+void SqliteResultSet::convertToVariant(Column &column) const
+{
+    const int rowCount = column.nulls.size();
+    column.variants.clear();
+    column.variants.reserve(rowCount);
+    for (int rowIndex = 0; rowIndex < rowCount; rowIndex++) {
+        if (column.nulls.at(rowIndex)) {
+            column.variants.append(QVariant());
+        }
+        else if (column.type == StorageType::INTEGER) {
+            column.variants.append(column.integers.at(rowIndex));
+        }
+        else if (column.type == StorageType::REAL) {
+            column.variants.append(column.reals.at(rowIndex));
+        }
+        else if (column.type == StorageType::TEXT) {
+            column.variants.append(column.texts.at(rowIndex));
+        }
+        else if (column.type == StorageType::BLOB) {
+            column.variants.append(column.blobs.at(rowIndex));
+        }
+        else {
+            column.variants.append(QVariant());
+        }
+    }
+
+    column.integers = QVector<qint64>();
+    column.reals = QVector<double>();
+    column.texts = QVector<QString>();
+    column.blobs = QVector<QByteArray>();
+    column.type = StorageType::VARIANT;
+}
+
+QVariant SqliteResultSet::getValue(int columnIndex, int rowIndex) const
+{
+    const Column &column = m_Columns.at(columnIndex);
+    if (column.nulls.at(rowIndex)) {
+        return QVariant();
+    }
+
+    QVariant value;
+    switch (column.type) {
+    case StorageType::NONE:
+        break;
+    case StorageType::INTEGER:
+        value = column.integers.at(rowIndex);
+        break;
+    case StorageType::REAL:
+        value = column.reals.at(rowIndex);
+        break;
+    case StorageType::TEXT:
+        value = column.texts.at(rowIndex);
+        break;
+    case StorageType::BLOB:
+        value = column.blobs.at(rowIndex);
+        break;
+    case StorageType::VARIANT:
+        value = column.variants.at(rowIndex);
+        break;
+    }
+
+    return value;
+}
+
+SqliteResultSet::StorageType SqliteResultSet::getValueStorageType(const QVariant &value)
+{
+    StorageType type = StorageType::VARIANT;
+    switch (static_cast<int>(value.type())) {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Bool:
+        type = StorageType::INTEGER;
+        break;
+    case QVariant::Double:
+        type = StorageType::REAL;
+        break;
+    case QVariant::String:
+        type = StorageType::TEXT;
+        break;
+    case QVariant::ByteArray:
+        type = StorageType::BLOB;
+        break;
+    default:
+        break;
+    }
+
+    return type;
+}
+
+}
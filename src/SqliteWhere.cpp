@@ -0,0 +1,169 @@
+#include "qutils/SqliteWhere.h"
+// Qt
+#include <QStringList>
+// qutils
+#include "qutils/Macros.h"
+
+namespace zmc
+{
+
+SqliteWhere::SqliteWhere()
+    : m_Conditions()
+    , m_BindValues()
+{
+
+}
+
+SqliteWhere &SqliteWhere::where(const QString &columnName, Operator op, const QVariant &value)
+{
+    return append("AND", quoteIdentifier(columnName), op, value);
+}
+
+SqliteWhere &SqliteWhere::andWhere(const QString &columnName, Operator op, const QVariant &value)
+{
+    return append("AND", quoteIdentifier(columnName), op, value);
+}
+
+SqliteWhere &SqliteWhere::orWhere(const QString &columnName, Operator op, const QVariant &value)
+{
+    return append("OR", quoteIdentifier(columnName), op, value);
+}
+
+SqliteWhere &SqliteWhere::whereExpression(const QString &expression, Operator op, const QVariant &value)
+{
+    return append("AND", expression, op, value);
+}
+
+SqliteWhere &SqliteWhere::andWhereExpression(const QString &expression, Operator op, const QVariant &value)
+{
+    return append("AND", expression, op, value);
+}
+
+SqliteWhere &SqliteWhere::orWhereExpression(const QString &expression, Operator op, const QVariant &value)
+{
+    return append("OR", expression, op, value);
+}
+
+SqliteWhere &SqliteWhere::andGroup(const SqliteWhere &group)
+{
+    return appendGroup("AND", group);
+}
+
+SqliteWhere &SqliteWhere::orGroup(const SqliteWhere &group)
+{
+    return appendGroup("OR", group);
+}
+
+bool SqliteWhere::isEmpty() const
+{
+    return m_Conditions.isEmpty();
+}
+
+QString SqliteWhere::getConditions() const
+{
+    return m_Conditions;
+}
+
+QString SqliteWhere::getQuery() const
+{
+    return isEmpty() ? QString() : "WHERE " + m_Conditions;
+}
+
+QVariantList SqliteWhere::getBindValues() const
+{
+    return m_BindValues;
+}
+
+QString SqliteWhere::quoteIdentifier(const QString &identifier)
+{
+    QString quoted = identifier;
+    return "\"" + quoted.replace("\"", "\"\"") + "\"";
+}
+
+SqliteWhere &SqliteWhere::append(const QString &joiner, const QString &leftOperand, Operator op, const QVariant &value)
+{
+    QString condition = leftOperand;
+    switch (op) {
+    case Operator::EQUAL:
+        condition += " = ?";
+        m_BindValues.append(value);
+        break;
+    case Operator::NOT_EQUAL:
+        condition += " <> ?";
+        m_BindValues.append(value);
+        break;
+    case Operator::LESS:
+        condition += " < ?";
+        m_BindValues.append(value);
+        break;
+    case Operator::LESS_OR_EQUAL:
+        condition += " <= ?";
+        m_BindValues.append(value);
+        break;
+    case Operator::GREATER:
+        condition += " > ?";
+        m_BindValues.append(value);
+        break;
+    case Operator::GREATER_OR_EQUAL:
+        condition += " >= ?";
+        m_BindValues.append(value);
+        break;
+    case Operator::IN:
+    case Operator::NOT_IN: {
+        const QVariantList values = value.toList();
+        QStringList placeholders;
+        for (const QVariant &item : values) {
+            placeholders.append("?");
+            m_BindValues.append(item);
+        }
+
+        condition += (op == Operator::IN ? " IN (" : " NOT IN (") + placeholders.join(',') + ")";
+        break;
+    }
+    case Operator::BETWEEN: {
+        const QVariantList values = value.toList();
+        if (values.size() != 2) {
+            LOG_ERROR("BETWEEN requires exactly two values!");
+        }
+
+        condition += " BETWEEN ? AND ?";
+        m_BindValues.append(values.value(0));
+        m_BindValues.append(values.value(1));
+        break;
+    }
+    case Operator::LIKE:
+        condition += " LIKE ?";
+        m_BindValues.append(value);
+        break;
+    case Operator::IS_NULL:
+        condition += " IS NULL";
+        break;
+    case Operator::IS_NOT_NULL:
+        condition += " IS NOT NULL";
+        break;
+    }
+
+    if (m_Conditions.isEmpty() == false) {
+        m_Conditions += " " + joiner + " ";
+    }
+
+    m_Conditions += condition;
+    return *this;
+}
+
+SqliteWhere &SqliteWhere::appendGroup(const QString &joiner, const SqliteWhere &group)
+{
+    if (group.isEmpty()) {
+        return *this;
+    }
+
+    if (m_Conditions.isEmpty() == false) {
+        m_Conditions += " " + joiner + " ";
+    }
+
+    m_Conditions += "(" + group.m_Conditions + ")";
+    m_BindValues.append(group.m_BindValues);
+    return *this;
+}
+
+}